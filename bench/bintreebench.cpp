@@ -0,0 +1,873 @@
+#include "bintree.h"
+#include "btree.h"
+#include "concurrentbintree.h"
+#include "frozentree.h"
+#include "mappedtree.h"
+#include "persistentbintree.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <new>
+#include <random>
+#include <unistd.h>
+
+/* bintreebench times every BinTree operation with Google Benchmark.
+ *
+ *      bintreebench [--max_keys=N] [--max_path_keys=N] [benchmark flags]
+ *
+ * Benchmarks are named operation/distribution/mode/keys. The keys are
+ * inserted in sorted, reverse, random or zigzag order (smallest, largest,
+ * second smallest, ...), into a default BinTree ("plain") or a balanced one
+ * ("avl"), at 1,000 to 10,000,000 keys. In a plain BinTree every order but
+ * random builds a single path, which makes building and searching it
+ * quadratic, so those runs stop at --max_path_keys (10,000 by default).
+ * --max_keys (10,000,000 by default) caps every run.
+ *
+ * Besides the time per iteration, each benchmark reports:
+ *
+ *      time_per_key    time per key handled, for whole-tree operations
+ *      allocs          heap allocations per iteration
+ *      alloc_bytes     bytes allocated per iteration
+ *      peak_rss        peak resident memory while the benchmark ran
+ *
+ * Pass --benchmark_format=json, or --benchmark_out=<file>, for JSON that can
+ * be kept and compared over time, and --benchmark_filter=<regex> to run
+ * only some of them. Operations that split across threads use about one
+ * thread per hardware thread.
+ *
+ * insert_key and retrieve_key build the same random trees from a
+ * BasicBinTree that keeps each key inside its Node ("string", "nodedata"),
+ * to compare with insert/random/avl and retrieve_hit/random/avl, where
+ * each Node points to its NodeData. Where Google Benchmark was built with
+ * libpfm, --benchmark_perf_counters=CYCLES,CACHE-MISSES adds the cache
+ * misses per iteration; otherwise the time_per_key of the two shows it.
+ * */
+
+enum Distribution { SORTED, REVERSE, RANDOM, ZIGZAG };
+
+static const char* const DISTRIBUTION_NAMES[] = {
+    "sorted", "reverse", "random", "zigzag"
+};
+
+// Lookups cycle through this many probe keys, in random order.
+static const int PROBE_KEYS = 1 << 16;
+
+// Threads that read, or insert, in the concurrent benchmarks.
+static const int THREAD_COUNTS[] = { 1, 2, 4, 8, 16, 32, 64 };
+
+static int maxKeys = 10000000;
+static int maxPathKeys = 10000;
+
+
+//-----------------------------allocation counting-----------------------------
+// Every heap allocation in the process goes through these, so a benchmark
+// can count what an operation allocated. Every form of operator delete is
+// replaced too, so each one frees what the operator new above it
+// allocated. They are kept out of line: inlined into a caller, GCC sees
+// free() called on a pointer from operator new and warns that they do not
+// match.
+#if defined(__GNUC__)
+#define OUT_OF_LINE __attribute__((noinline))
+#else
+#define OUT_OF_LINE
+#endif
+
+static atomic<uint64_t> allocationCount(0);
+static atomic<uint64_t> allocationBytes(0);
+
+OUT_OF_LINE void* operator new(size_t size) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    allocationBytes.fetch_add(size, memory_order_relaxed);
+    void* memory = malloc(size == 0 ? 1 : size);
+    if (memory == NULL) {
+        throw bad_alloc();
+    }
+    return memory;
+}
+
+OUT_OF_LINE void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+OUT_OF_LINE void operator delete(void* memory) noexcept {
+    free(memory);
+}
+
+OUT_OF_LINE void operator delete[](void* memory) noexcept {
+    free(memory);
+}
+
+OUT_OF_LINE void operator delete(void* memory, size_t) noexcept {
+    free(memory);
+}
+
+OUT_OF_LINE void operator delete[](void* memory, size_t) noexcept {
+    free(memory);
+}
+
+#ifdef __cpp_aligned_new
+OUT_OF_LINE void* operator new(size_t size, align_val_t alignment) {
+    allocationCount.fetch_add(1, memory_order_relaxed);
+    allocationBytes.fetch_add(size, memory_order_relaxed);
+    size_t align = static_cast<size_t>(alignment);
+    void* memory = aligned_alloc(align, (size + align - 1) / align * align);
+    if (memory == NULL) {
+        throw bad_alloc();
+    }
+    return memory;
+}
+
+OUT_OF_LINE void* operator new[](size_t size, align_val_t alignment) {
+    return operator new(size, alignment);
+}
+
+OUT_OF_LINE void operator delete(void* memory, align_val_t) noexcept {
+    free(memory);
+}
+
+OUT_OF_LINE void operator delete[](void* memory, align_val_t) noexcept {
+    free(memory);
+}
+
+OUT_OF_LINE void operator delete(void* memory, size_t, align_val_t)
+        noexcept {
+    free(memory);
+}
+
+OUT_OF_LINE void operator delete[](void* memory, size_t, align_val_t)
+        noexcept {
+    free(memory);
+}
+#endif
+
+
+
+/*--------------------------------------Meter----------------------------------
+ * Counts the allocations made while it is running and reports them, with
+ * the time per key and the peak resident memory, as benchmark counters.
+ * start() and stop() bracket the part of each iteration being timed, so
+ * setup done with the timer paused is not counted.
+ *---------------------------------------------------------------------------*/
+class Meter {
+public:
+
+    /*--------------------------------Constructor------------------------------
+     * Pre: None.
+     *
+     * Post: Clears the process's peak resident memory, where Linux allows
+     *       it, so that peak_rss only covers this benchmark.
+     *-----------------------------------------------------------------------*/
+    Meter() : count(0), bytes(0) {
+        ofstream clearRefs("/proc/self/clear_refs");
+        clearRefs << "5";
+    }
+
+    void start() {
+        startCount = allocationCount.load(memory_order_relaxed);
+        startBytes = allocationBytes.load(memory_order_relaxed);
+    }
+
+    void stop() {
+        count += allocationCount.load(memory_order_relaxed) - startCount;
+        bytes += allocationBytes.load(memory_order_relaxed) - startBytes;
+    }
+
+
+    /*---------------------------------report----------------------------------
+     * Pre: Takes in the State of a finished benchmark and how many keys
+     *      each iteration handled.
+     *
+     * Post: Adds the time_per_key, allocs, alloc_bytes and peak_rss
+     *       counters.
+     *-----------------------------------------------------------------------*/
+    void report(benchmark::State& state, int64_t keysPerIteration) {
+        typedef benchmark::Counter Counter;
+        state.SetItemsProcessed(state.iterations() * keysPerIteration);
+        state.counters["time_per_key"] = Counter(keysPerIteration
+                , Counter::kIsIterationInvariantRate | Counter::kInvert);
+        state.counters["allocs"] = Counter(static_cast<double>(count)
+                , Counter::kAvgIterations);
+        state.counters["alloc_bytes"] = Counter(static_cast<double>(bytes)
+                , Counter::kAvgIterations, Counter::OneK::kIs1024);
+        state.counters["peak_rss"] = Counter(peakRss(), Counter::kDefaults
+                , Counter::OneK::kIs1024);
+    }
+
+private:
+    uint64_t count;                         // allocations while running
+    uint64_t bytes;                         // bytes allocated while running
+    uint64_t startCount;
+    uint64_t startBytes;
+
+    // Returns the peak resident memory in bytes from /proc/self/status, or
+    // 0 if it cannot be read.
+    static double peakRss() {
+        ifstream status("/proc/self/status");
+        string line;
+        while (getline(status, line)) {
+            if (line.compare(0, 6, "VmHWM:") == 0) {
+                return 1024.0 * atof(line.c_str() + 6);
+            }
+        }
+        return 0;
+    }
+};
+
+
+
+/*---------------------------------------key-----------------------------------
+ * Pre: Takes in an int, i.
+ *
+ * Post: Returns i as a zero-padded string, so keys sort as numbers do.
+ *---------------------------------------------------------------------------*/
+static string key(int i) {
+    char text[16];
+    snprintf(text, sizeof(text), "%010d", i);
+    return text;
+}
+
+
+
+/*------------------------------------makeKeys---------------------------------
+ * Pre: Takes in a number of keys, size, and a Distribution.
+ *
+ * Post: Returns the even keys 0, 2, ... 2 * (size - 1) in the order given by
+ *       the Distribution, so every odd key is a miss. Random order is the
+ *       same on every run.
+ *---------------------------------------------------------------------------*/
+static vector<string> makeKeys(int size, Distribution distribution) {
+    vector<string> keys;
+    keys.reserve(size);
+    for (int i = 0; i < size; i++) {
+        int rank = i;
+        if (distribution == REVERSE) {
+            rank = size - 1 - i;
+        } else if (distribution == ZIGZAG) {
+            rank = i % 2 == 0 ? i / 2 : size - 1 - i / 2;
+        }
+        keys.push_back(key(2 * rank));
+    }
+    if (distribution == RANDOM) {
+        shuffle(keys.begin(), keys.end(), mt19937(size));
+    }
+    return keys;
+}
+
+
+
+/*-------------------------------------makeProbes------------------------------
+ * Pre: Takes in the keys in a tree and whether the probes should miss.
+ *
+ * Post: Returns up to PROBE_KEYS NodeData in random order, each equal to
+ *       one of the keys, or falling between two of them if miss is true.
+ *---------------------------------------------------------------------------*/
+static vector<NodeData> makeProbes(const vector<string>& keys, bool miss) {
+    mt19937 random(7);
+    vector<NodeData> probes;
+    int count = min(static_cast<int>(keys.size()), PROBE_KEYS);
+    for (int i = 0; i < count; i++) {
+        int index = random() % keys.size();
+        probes.push_back(NodeData(miss ? key(atoi(keys[index].c_str()) + 1)
+                : keys[index]));
+    }
+    return probes;
+}
+
+
+
+/*------------------------------------buildTree--------------------------------
+ * Pre: Takes in a reference to an empty BinTree, tree, and keys.
+ *
+ * Post: Inserts a new NodeData for each key, in order.
+ *---------------------------------------------------------------------------*/
+static void buildTree(BinTree& tree, const vector<string>& keys) {
+    for (size_t i = 0; i < keys.size(); i++) {
+        tree.insert(new NodeData(keys[i]));
+    }
+}
+
+
+
+/*-----------------------------------Tree operations---------------------------
+ * Each one builds the keys for its size and distribution, and whatever else
+ * it needs, before the timer starts or with it paused, and times one
+ * operation per iteration.
+ *---------------------------------------------------------------------------*/
+static void benchInsert(benchmark::State& state, int size
+        , Distribution distribution, bool balanced) {
+    vector<string> keys = makeKeys(size, distribution);
+    Meter meter;
+    for (auto _ : state) {
+        BinTree* tree = new BinTree(balanced);
+        meter.start();
+        buildTree(*tree, keys);
+        meter.stop();
+        state.PauseTiming();
+        delete tree;
+        state.ResumeTiming();
+    }
+    meter.report(state, size);
+}
+
+static void benchLookup(benchmark::State& state, int size
+        , Distribution distribution, bool balanced, bool miss, bool height) {
+    vector<string> keys = makeKeys(size, distribution);
+    BinTree tree(balanced);
+    buildTree(tree, keys);
+    vector<NodeData> probes = makeProbes(keys, miss);
+    size_t next = 0;
+    NodeData* found;
+    Meter meter;
+    meter.start();
+    for (auto _ : state) {
+        const NodeData& probe = probes[next];
+        next = next + 1 == probes.size() ? 0 : next + 1;
+        if (height) {
+            benchmark::DoNotOptimize(tree.getHeight(probe));
+        } else {
+            benchmark::DoNotOptimize(tree.retrieve(probe, found));
+        }
+    }
+    meter.stop();
+    meter.report(state, 1);
+}
+
+static void benchCopy(benchmark::State& state, int size
+        , Distribution distribution, bool balanced) {
+    BinTree tree(balanced);
+    buildTree(tree, makeKeys(size, distribution));
+    Meter meter;
+    for (auto _ : state) {
+        meter.start();
+        BinTree* copy = new BinTree(tree);
+        meter.stop();
+        state.PauseTiming();
+        delete copy;
+        state.ResumeTiming();
+    }
+    meter.report(state, size);
+}
+
+static void benchEqual(benchmark::State& state, int size
+        , Distribution distribution, bool balanced) {
+    BinTree tree(balanced);
+    buildTree(tree, makeKeys(size, distribution));
+    BinTree copy(tree);
+    Meter meter;
+    meter.start();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tree == copy);
+    }
+    meter.stop();
+    meter.report(state, size);
+}
+
+static void benchMakeEmpty(benchmark::State& state, int size
+        , Distribution distribution, bool balanced) {
+    BinTree tree(balanced);
+    buildTree(tree, makeKeys(size, distribution));
+    Meter meter;
+    for (auto _ : state) {
+        state.PauseTiming();
+        BinTree copy(tree);
+        state.ResumeTiming();
+        meter.start();
+        copy.makeEmpty();
+        meter.stop();
+    }
+    meter.report(state, size);
+}
+
+static void benchToArray(benchmark::State& state, int size
+        , Distribution distribution, bool balanced) {
+    BinTree tree(balanced);
+    buildTree(tree, makeKeys(size, distribution));
+    vector<NodeData*> array(size + 1);
+    Meter meter;
+    for (auto _ : state) {
+        state.PauseTiming();
+        BinTree copy(tree);
+        state.ResumeTiming();
+        meter.start();
+        copy.bstreeToArray(&array[0]);
+        meter.stop();
+        state.PauseTiming();
+        for (int i = 0; i < size; i++) {
+            delete array[i];
+        }
+        state.ResumeTiming();
+    }
+    meter.report(state, size);
+}
+
+static void benchArrayToBSTree(benchmark::State& state, int size) {
+    vector<string> keys = makeKeys(size, SORTED);
+    vector<NodeData*> array(size + 1);
+    BinTree tree;
+    Meter meter;
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (int i = 0; i < size; i++) {
+            array[i] = new NodeData(keys[i]);
+        }
+        state.ResumeTiming();
+        meter.start();
+        tree.arrayToBSTree(&array[0], size);
+        meter.stop();
+        state.PauseTiming();
+        tree.makeEmpty();
+        state.ResumeTiming();
+    }
+    meter.report(state, size);
+}
+
+static void benchChurn(benchmark::State& state, int size
+        , Distribution distribution, bool balanced) {
+    vector<string> present = makeKeys(size, distribution);
+    BinTree tree(balanced);
+    buildTree(tree, present);
+    vector<string> absent;
+    for (int i = 0; i < size; i++) {
+        absent.push_back(key(atoi(present[i].c_str()) + 1));
+    }
+    mt19937 random(11);
+    NodeData* removedPtr;
+    Meter meter;
+    meter.start();
+    for (auto _ : state) {
+        size_t index = random() % present.size();
+        tree.remove(NodeData(present[index]), removedPtr);
+        delete removedPtr;
+        tree.insert(new NodeData(absent[index]));
+        present[index].swap(absent[index]);
+    }
+    meter.stop();
+    meter.report(state, 2);
+}
+
+
+
+/*----------------------------------Key storage--------------------------------
+ * The same random inserts and hits as insert/random/avl and
+ * retrieve_hit/random/avl, in a Tree that stores its keys by value.
+ *---------------------------------------------------------------------------*/
+template <class Tree>
+static void benchKeyInsert(benchmark::State& state, int size) {
+    typedef typename Tree::key_type Key;
+    vector<string> keys = makeKeys(size, RANDOM);
+    Meter meter;
+    for (auto _ : state) {
+        Tree* tree = new Tree(true);
+        meter.start();
+        for (int i = 0; i < size; i++) {
+            tree->insert(Key(keys[i]));
+        }
+        meter.stop();
+        state.PauseTiming();
+        delete tree;
+        state.ResumeTiming();
+    }
+    meter.report(state, size);
+}
+
+template <class Tree>
+static void benchKeyLookup(benchmark::State& state, int size) {
+    typedef typename Tree::key_type Key;
+    vector<string> keys = makeKeys(size, RANDOM);
+    Tree tree(true);
+    for (int i = 0; i < size; i++) {
+        tree.insert(Key(keys[i]));
+    }
+    mt19937 random(7);                      // the probes makeProbes() picks
+    vector<Key> probes;
+    int count = min(size, PROBE_KEYS);
+    for (int i = 0; i < count; i++) {
+        probes.push_back(Key(keys[random() % keys.size()]));
+    }
+    size_t next = 0;
+    typename Tree::data_pointer found;
+    Meter meter;
+    meter.start();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tree.retrieve(probes[next], found));
+        next = next + 1 == probes.size() ? 0 : next + 1;
+    }
+    meter.stop();
+    meter.report(state, 1);
+}
+
+
+
+/*--------------------------------Other structures-----------------------------
+ * Random lookups in the other read paths, to compare with
+ * retrieve_hit/random/avl at the same size.
+ *---------------------------------------------------------------------------*/
+static void benchFrozenLookup(benchmark::State& state, int size) {
+    vector<string> keys = makeKeys(size, RANDOM);
+    BinTree tree(true);
+    buildTree(tree, keys);
+    FrozenTree frozen = tree.freeze();
+    tree.makeEmpty();
+    vector<NodeData> probes = makeProbes(keys, false);
+    size_t next = 0;
+    const NodeData* found;
+    Meter meter;
+    meter.start();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(frozen.retrieve(probes[next], found));
+        next = next + 1 == probes.size() ? 0 : next + 1;
+    }
+    meter.stop();
+    meter.report(state, 1);
+}
+
+static void benchBTreeLookup(benchmark::State& state, int size) {
+    vector<string> keys = makeKeys(size, RANDOM);
+    BTree tree;
+    for (int i = 0; i < size; i++) {
+        tree.insert(new NodeData(keys[i]));
+    }
+    vector<NodeData> probes = makeProbes(keys, false);
+    size_t next = 0;
+    NodeData* found;
+    Meter meter;
+    meter.start();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(tree.retrieve(probes[next], found));
+        next = next + 1 == probes.size() ? 0 : next + 1;
+    }
+    meter.stop();
+    meter.report(state, 1);
+}
+
+
+
+/*-------------------------------Serialization---------------------------------
+ * writeBinary() once, then time reading the file back into a BinTree, or
+ * answering lookups from it with MappedTree.
+ *---------------------------------------------------------------------------*/
+static string writeTreeFile(const vector<string>& keys) {
+    char path[] = "/tmp/bintreebench-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        close(fd);
+    }
+    BinTree tree(true);
+    buildTree(tree, keys);
+    ofstream file(path, ios::binary);
+    tree.writeBinary(file);
+    return path;
+}
+
+static void benchReadBinary(benchmark::State& state, int size) {
+    string path = writeTreeFile(makeKeys(size, RANDOM));
+    BinTree tree;
+    Meter meter;
+    for (auto _ : state) {
+        meter.start();
+        ifstream file(path.c_str(), ios::binary);
+        tree.readBinary(file);
+        meter.stop();
+        state.PauseTiming();
+        tree.makeEmpty();
+        state.ResumeTiming();
+    }
+    meter.report(state, size);
+    unlink(path.c_str());
+}
+
+static void benchMappedLookup(benchmark::State& state, int size) {
+    vector<string> keys = makeKeys(size, RANDOM);
+    string path = writeTreeFile(keys);
+    MappedTree mapped;
+    mapped.open(path.c_str());
+    vector<NodeData> probes = makeProbes(keys, false);
+    size_t next = 0;
+    NodeData found;
+    Meter meter;
+    meter.start();
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(mapped.retrieve(probes[next], found));
+        next = next + 1 == probes.size() ? 0 : next + 1;
+    }
+    meter.stop();
+    meter.report(state, 1);
+    mapped.close();
+    unlink(path.c_str());
+}
+
+
+
+/*-------------------------------PersistentBinTree-----------------------------
+ * The cost of a snapshot, and of a snapshot followed by the insert that then
+ * has to copy a path, in time and bytes. Compare with copy/random/avl, the
+ * deep copy a snapshot replaces.
+ *---------------------------------------------------------------------------*/
+static void benchSnapshot(benchmark::State& state, int size
+        , bool insertAfter) {
+    vector<string> keys = makeKeys(size, RANDOM);
+    PersistentBinTree tree;
+    for (int i = 0; i < size; i++) {
+        tree.insert(new NodeData(keys[i]));
+    }
+    int next = 0;
+    Meter meter;
+    meter.start();
+    for (auto _ : state) {
+        PersistentBinTree snapshot = tree.snapshot();
+        if (insertAfter) {
+            tree.insert(new NodeData(key(2 * next++ + 1)));
+        }
+    }
+    meter.stop();
+    meter.report(state, 1);
+}
+
+
+
+/*--------------------------------ConcurrentBinTree----------------------------
+ * Thread 0 sets up a shared ConcurrentBinTree before the timed loop, which
+ * every thread waits for, and tears it down after it.
+ *
+ * concurrent_read: thread 0 keeps inserting new keys while every other
+ * thread looks up random keys. Only the lookups are counted. The tree is
+ * first built from random keys, or from sorted keys, which the tree does
+ * not rebalance: it becomes one long path and every lookup walks O(n) of
+ * it.
+ *
+ * concurrent_insert: every thread inserts random keys, either spread over
+ * a large range (uniform) or all from the same 64 keys (hotkey), in which
+ * case almost every insert finds its key already there. Or the threads take
+ * turns drawing the next key from one shared counter (monotone), so every
+ * insert races for the tree's rightmost link, which is the worst case for
+ * its compare-and-swap, and the tree grows into one long path. Monotone
+ * runs stop after maxPathKeys inserts in all.
+ *---------------------------------------------------------------------------*/
+enum KeyPattern { UNIFORM, HOTKEY, MONOTONE };
+
+static const char* const KEY_PATTERN_NAMES[] = {
+    "uniform", "hotkey", "monotone"
+};
+
+static ConcurrentBinTree* sharedTree = NULL;
+
+static void benchConcurrentRead(benchmark::State& state, int size
+        , Distribution distribution) {
+    vector<string> keys = makeKeys(size, distribution);
+    if (state.thread_index() == 0) {
+        sharedTree = new ConcurrentBinTree();
+        for (int i = 0; i < size; i++) {
+            sharedTree->insert(new NodeData(keys[i]));
+        }
+    }
+    vector<NodeData> probes = makeProbes(keys, false);
+    size_t next = state.thread_index() * 997 % probes.size();
+    int written = 0;
+    NodeData* found;
+    for (auto _ : state) {
+        if (state.thread_index() == 0) {
+            NodeData* dataPtr = new NodeData(key(2 * written++ + 1));
+            if (!sharedTree->insert(dataPtr)) {
+                delete dataPtr;
+            }
+        } else {
+            benchmark::DoNotOptimize(sharedTree->retrieve(probes[next]
+                    , found));
+            next = next + 1 == probes.size() ? 0 : next + 1;
+        }
+    }
+    if (state.thread_index() != 0) {
+        state.SetItemsProcessed(state.iterations());
+    } else {
+        delete sharedTree;
+        sharedTree = NULL;
+    }
+}
+
+static atomic<int> nextMonotoneKey(0);
+
+static void benchConcurrentInsert(benchmark::State& state
+        , KeyPattern pattern) {
+    if (state.thread_index() == 0) {
+        sharedTree = new ConcurrentBinTree();
+        nextMonotoneKey.store(0);
+    }
+    mt19937 random(state.thread_index() + 1);
+    for (auto _ : state) {
+        int value;
+        if (pattern == MONOTONE) {
+            value = nextMonotoneKey.fetch_add(1, memory_order_relaxed);
+        } else {
+            value = pattern == HOTKEY ? random() % 64 : random() % 1000000000;
+        }
+        NodeData* dataPtr = new NodeData(key(value));
+        if (!sharedTree->insert(dataPtr)) {
+            delete dataPtr;
+        }
+    }
+    state.SetItemsProcessed(state.iterations());
+    if (state.thread_index() == 0) {
+        delete sharedTree;
+        sharedTree = NULL;
+    }
+}
+
+
+
+/*-----------------------------------------add---------------------------------
+ * Pre: Takes in the parts of a benchmark's name, operation, distribution,
+ *      mode and size, where distribution and mode may be NULL, then the
+ *      benchmark function and the arguments to pass it after its State.
+ *
+ * Post: Registers the benchmark as operation/distribution/mode/size and
+ *       returns it.
+ *---------------------------------------------------------------------------*/
+template <class Function, class... Args>
+static benchmark::internal::Benchmark* add(const char* operation
+        , const char* distribution, const char* mode, int size
+        , Function function, Args... args) {
+    string name = operation;
+    if (distribution != NULL) {
+        name = name + "/" + distribution;
+    }
+    if (mode != NULL) {
+        name = name + "/" + mode;
+    }
+    if (size > 0) {
+        name = name + "/" + to_string(size);
+    }
+    return benchmark::RegisterBenchmark(name.c_str(), function, args...);
+}
+
+
+
+/*----------------------------------registerAll--------------------------------
+ * Pre: None.
+ *
+ * Post: Registers every benchmark at 1,000, 10,000, ... keys, up to
+ *       maxKeys, skipping plain BinTrees and ConcurrentBinTrees built from
+ *       ordered keys above maxPathKeys.
+ *---------------------------------------------------------------------------*/
+static void registerAll() {
+    const benchmark::TimeUnit ms = benchmark::kMillisecond;
+    for (long long wide = 1000; wide <= maxKeys; wide *= 10) {
+        int size = static_cast<int>(wide);
+        for (int d = SORTED; d <= ZIGZAG; d++) {
+            Distribution distribution = static_cast<Distribution>(d);
+            const char* dist = DISTRIBUTION_NAMES[d];
+            for (int avl = 0; avl < 2; avl++) {
+                bool balanced = avl != 0;
+                const char* mode = balanced ? "avl" : "plain";
+                if (!balanced && distribution != RANDOM
+                        && size > maxPathKeys) {
+                    continue;
+                }
+                add("insert", dist, mode, size, benchInsert, size
+                        , distribution, balanced)->Unit(ms);
+                add("retrieve_hit", dist, mode, size, benchLookup, size
+                        , distribution, balanced, false, false);
+                add("retrieve_miss", dist, mode, size, benchLookup, size
+                        , distribution, balanced, true, false);
+                add("getHeight", dist, mode, size, benchLookup, size
+                        , distribution, balanced, false, true);
+                add("copy", dist, mode, size, benchCopy, size
+                        , distribution, balanced)->Unit(ms);
+                add("equal", dist, mode, size, benchEqual, size
+                        , distribution, balanced)->Unit(ms);
+                add("makeEmpty", dist, mode, size, benchMakeEmpty, size
+                        , distribution, balanced)->Unit(ms);
+                add("bstreeToArray", dist, mode, size, benchToArray, size
+                        , distribution, balanced)->Unit(ms);
+                if (distribution == RANDOM) {
+                    add("churn", dist, mode, size, benchChurn, size
+                            , distribution, balanced);
+                }
+            }
+        }
+
+        add("arrayToBSTree", "sorted", NULL, size, benchArrayToBSTree
+                , size)->Unit(ms);
+        add("insert_key", "random", "string", size
+                , benchKeyInsert<BasicBinTree<string> >, size)->Unit(ms);
+        add("insert_key", "random", "nodedata", size
+                , benchKeyInsert<BasicBinTree<NodeData> >, size)->Unit(ms);
+        add("retrieve_key", "random", "string", size
+                , benchKeyLookup<BasicBinTree<string> >, size);
+        add("retrieve_key", "random", "nodedata", size
+                , benchKeyLookup<BasicBinTree<NodeData> >, size);
+        add("lookup_frozen", "random", NULL, size, benchFrozenLookup, size);
+        add("lookup_btree", "random", NULL, size, benchBTreeLookup, size);
+        add("lookup_mapped", "random", NULL, size, benchMappedLookup, size);
+        add("readBinary", "random", NULL, size, benchReadBinary, size)
+                ->Unit(ms);
+        add("snapshot", "random", NULL, size, benchSnapshot, size, false);
+        add("snapshot_then_insert", "random", NULL, size, benchSnapshot
+                , size, true);
+
+        for (int d = SORTED; d <= RANDOM; d++) {
+            Distribution distribution = static_cast<Distribution>(d);
+            if (distribution == REVERSE
+                    || (distribution == SORTED && size > maxPathKeys)) {
+                continue;
+            }
+            benchmark::internal::Benchmark* readers = add("concurrent_read"
+                    , DISTRIBUTION_NAMES[d], NULL, size, benchConcurrentRead
+                    , size, distribution);
+            for (size_t t = 0; t < sizeof(THREAD_COUNTS) / sizeof(int); t++) {
+                readers->Threads(THREAD_COUNTS[t] + 1);    // and the writer
+            }
+            readers->UseRealTime();
+        }
+    }
+
+    for (int p = UNIFORM; p <= HOTKEY; p++) {
+        benchmark::internal::Benchmark* writers = add("concurrent_insert"
+                , KEY_PATTERN_NAMES[p], NULL, 0, benchConcurrentInsert
+                , static_cast<KeyPattern>(p));
+        for (size_t t = 0; t < sizeof(THREAD_COUNTS) / sizeof(int); t++) {
+            writers->Threads(THREAD_COUNTS[t]);
+        }
+        writers->UseRealTime();
+    }
+    for (size_t t = 0; t < sizeof(THREAD_COUNTS) / sizeof(int); t++) {
+        add("concurrent_insert", KEY_PATTERN_NAMES[MONOTONE], NULL, 0
+                , benchConcurrentInsert, MONOTONE)
+                ->Threads(THREAD_COUNTS[t])
+                ->Iterations(max(1, maxPathKeys / THREAD_COUNTS[t]))
+                ->UseRealTime();
+    }
+}
+
+
+
+/*---------------------------------------main----------------------------------
+ * Pre: Takes in the command line.
+ *
+ * Post: Takes out --max_keys and --max_path_keys, hands the rest to Google
+ *       Benchmark, registers every benchmark and runs the ones selected.
+ *---------------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+    int kept = 1;
+    for (int i = 1; i < argc; i++) {
+        if (strncmp(argv[i], "--max_keys=", 11) == 0) {
+            maxKeys = atoi(argv[i] + 11);
+        } else if (strncmp(argv[i], "--max_path_keys=", 16) == 0) {
+            maxPathKeys = atoi(argv[i] + 16);
+        } else {
+            argv[kept++] = argv[i];
+        }
+    }
+    argc = kept;
+    benchmark::Initialize(&argc, argv);
+    if (benchmark::ReportUnrecognizedArguments(argc, argv)) {
+        return 1;
+    }
+    registerAll();
+    benchmark::RunSpecifiedBenchmarks();
+    benchmark::Shutdown();
+    return 0;
+}
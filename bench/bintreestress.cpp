@@ -0,0 +1,266 @@
+#include "bintree.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <fcntl.h>
+#include <unistd.h>
+
+/* bintreestress runs every BinTree walk over BinTrees that have degenerated
+ * into a single path, to show that none of them uses native stack in
+ * proportion to the height of the tree.
+ *
+ *      bintreestress [nodes] [sidewaysNodes]
+ *
+ * Each shape is built with nodes NodeData (10,000,000 by default). Every
+ * Node hangs off the right of the one above it, off the left, or alternately
+ * off the right and the left. displaySideways() writes a line indented by
+ * the depth of each Node, so its output grows with the square of the
+ * height; it is run on a path of sidewaysNodes (2,000 by default) instead.
+ * All output goes to /dev/null. Prints one line per step and exits with 1
+ * if any check fails.
+ * */
+
+enum Shape { RIGHT_PATH, LEFT_PATH, ZIGZAG_PATH };
+
+static bool failed = false;
+
+
+/*------------------------------------BinTreeStress----------------------------
+ * Builds a list-shaped BinTree in O(n), which insert() could only do in
+ * O(n^2). It is a friend of BinTree.
+ *---------------------------------------------------------------------------*/
+class BinTreeStress {
+public:
+
+    /*--------------------------------buildPath--------------------------------
+     * Pre: Takes in a reference to an empty, unbalanced BinTree, tree. Takes
+     *      in an array of size NodeData pointers, sorted, in increasing
+     *      order, and the Shape of the path to build.
+     *
+     * Post: Makes tree a single path holding every NodeData in sorted, which
+     *       it now owns. RIGHT_PATH starts at the smallest and goes right,
+     *       LEFT_PATH starts at the largest and goes left, and ZIGZAG_PATH
+     *       takes the smallest and largest left in turn, so it goes right,
+     *       left, right, ... Each Node hangs on whichever side of the one
+     *       above it keeps the BinTree in order. Heights, sizes and parents
+     *       are filled in from the bottom up.
+     *-----------------------------------------------------------------------*/
+    static void buildPath(BinTree& tree, NodeData* sorted[], int size
+            , Shape shape) {
+        vector<BinTree::Node*> path;
+        path.reserve(size);
+        int low = 0;
+        int high = size - 1;
+        for (int i = 0; i < size; i++) {
+            bool takeLow = shape == RIGHT_PATH
+                    || (shape == ZIGZAG_PATH && i % 2 == 0);
+            BinTree::Node* nodePtr = tree.newNode(takeLow ? sorted[low++]
+                    : sorted[high--]);
+            if (!path.empty()) {
+                if (*nodePtr->data < *path.back()->data) {
+                    path.back()->left = nodePtr;
+                } else {
+                    path.back()->right = nodePtr;
+                }
+            }
+            path.push_back(nodePtr);
+        }
+        for (int i = size - 1; i >= 0; i--) {
+            BinTree::updateNode(path[i]);
+        }
+        tree.root = size > 0 ? path[0] : NULL;
+    }
+};
+
+
+/*---------------------------------------key-----------------------------------
+ * Pre: Takes in an int, i.
+ *
+ * Post: Returns i as a zero-padded string, so keys sort as numbers do.
+ *---------------------------------------------------------------------------*/
+static string key(int i) {
+    char text[16];
+    snprintf(text, sizeof(text), "%010d", i);
+    return text;
+}
+
+
+
+/*--------------------------------------step-----------------------------------
+ * Pre: Takes in the name of a step that has just finished, when it started,
+ *      and whether its checks passed.
+ *
+ * Post: Prints the step and how long it took, and remembers a failure.
+ *---------------------------------------------------------------------------*/
+static void step(const char* name, chrono::steady_clock::time_point start
+        , bool passed) {
+    double seconds = chrono::duration<double>(chrono::steady_clock::now()
+            - start).count();
+    printf("    %-28s %8.3f s  %s\n", name, seconds, passed ? "ok" : "FAILED");
+    fflush(stdout);
+    failed = failed || !passed;
+}
+
+
+
+/*-------------------------------------build-----------------------------------
+ * Pre: Takes in a reference to an empty BinTree, tree, a number of Nodes,
+ *      size, and a Shape.
+ *
+ * Post: Fills tree with size new NodeData, keys 0 to size - 1, in the
+ *       given shape.
+ *---------------------------------------------------------------------------*/
+static void build(BinTree& tree, int size, Shape shape) {
+    vector<NodeData*> sorted(size);
+    for (int i = 0; i < size; i++) {
+        sorted[i] = new NodeData(key(i));
+    }
+    BinTreeStress::buildPath(tree, size > 0 ? &sorted[0] : NULL, size, shape);
+}
+
+
+
+/*--------------------------------------count----------------------------------
+ * Pre: Takes in a NodeData and a pointer to an int counter.
+ *
+ * Post: Adds one to the counter. Used with visitInorder().
+ *---------------------------------------------------------------------------*/
+static void count(const NodeData&, void* counter) {
+    (*static_cast<int*>(counter))++;
+}
+
+
+
+/*-------------------------------------runShape--------------------------------
+ * Pre: Takes in a number of Nodes, size, at least 2, the number of Nodes to
+ *      display sideways, and a Shape with its name.
+ *
+ * Post: Builds the shape and runs every walk over it, printing each step.
+ *---------------------------------------------------------------------------*/
+static void runShape(int size, int sidewaysSize, Shape shape
+        , const char* name) {
+    typedef chrono::steady_clock clock;
+    printf("%s, %d Nodes\n", name, size);
+    ofstream devNull("/dev/null");
+    clock::time_point start = clock::now();
+
+    BinTree tree;
+    build(tree, size, shape);
+    step("build", start, tree.height() == size && tree.size() == size);
+
+    start = clock::now();
+    NodeData* dataPtr;
+    int bottom = shape == LEFT_PATH ? 0 : shape == RIGHT_PATH ? size - 1
+            : size / 2;                     // where the two ends meet
+    bool found = tree.retrieve(NodeData(key(bottom)), dataPtr);
+    step("retrieve deepest", start, found
+            && tree.getHeight(NodeData(key(bottom))) == 1);
+
+    start = clock::now();
+    int visited = 0;
+    tree.visitInorder(count, &visited);
+    bool ordered = true;
+    int forward = 0;
+    BinTree::const_iterator last = tree.end();
+    for (BinTree::const_iterator it = tree.begin(); it != tree.end(); ++it) {
+        ordered = ordered && (forward == 0 || *last < *it);
+        last = it;
+        forward++;
+    }
+    int backward = 0;
+    BinTree::const_iterator first = tree.begin();
+    for (BinTree::const_iterator it = tree.end(); it != first; --it) {
+        backward++;
+    }
+    step("visit and iterate", start, visited == size && forward == size
+            && backward == size && ordered);
+
+    start = clock::now();
+    ShapeReport report = tree.shapeReport();
+    step("shapeReport", start, report.height == size && report.size == size);
+
+    start = clock::now();
+    devNull << tree;
+    int fd = open("/dev/null", O_WRONLY);
+    bool written = tree.outputToFd(fd);
+    close(fd);
+    step("output", start, devNull.good() && written);
+
+    start = clock::now();
+    BinTree copy(tree);
+    step("copy", start, copy.height() == size);
+
+    start = clock::now();
+    bool equal = copy == tree;
+    copy.insert(new NodeData(key(size)));
+    step("compare", start, equal && copy != tree);
+
+    start = clock::now();
+    copy.makeEmpty();
+    step("makeEmpty", start, copy.isEmpty());
+
+    start = clock::now();
+    vector<NodeData*> exported;
+    tree.copyToVector(exported);
+    bool exportedAll = exported.size() == static_cast<size_t>(size);
+    for (size_t i = 0; i < exported.size(); i++) {
+        delete exported[i];
+    }
+    step("copyToVector", start, exportedAll);
+
+    start = clock::now();
+    vector<NodeData*> moved(size + 1);
+    tree.bstreeToArray(&moved[0]);
+    bool emptied = tree.isEmpty() && moved[size - 1] != NULL;
+    bool rebuilt = tree.arrayToBSTree(&moved[0], size, true);
+    for (int i = 0; i < size && !rebuilt; i++) {
+        delete moved[i];
+    }
+    step("bstreeToArray round trip", start, emptied && rebuilt
+            && tree.size() == size && tree.height() < 64);
+
+    start = clock::now();
+    tree.makeEmpty();
+    build(tree, size, shape);
+    NodeData* removedPtr;
+    bool removed = tree.remove(NodeData(key(bottom)), removedPtr);
+    delete removedPtr;
+    step("remove deepest", start, removed && tree.size() == size - 1);
+
+    start = clock::now();
+    BinTree sideways;
+    build(sideways, sidewaysSize, shape);
+    sideways.displaySideways(devNull);
+    step("displaySideways", start, devNull.good());
+
+    {
+        BinTree doomed;
+        build(doomed, size, shape);
+        start = clock::now();
+    }
+    step("destructor", start, true);
+}
+
+
+
+/*---------------------------------------main----------------------------------
+ * Pre: Takes in the optional number of Nodes, and of Nodes to display
+ *      sideways, on the command line.
+ *
+ * Post: Runs every shape. Returns 0 if every check passed, 1 otherwise.
+ *---------------------------------------------------------------------------*/
+int main(int argc, char* argv[]) {
+    int size = argc > 1 ? atoi(argv[1]) : 10000000;
+    int sidewaysSize = argc > 2 ? atoi(argv[2]) : 2000;
+    if (size < 2 || sidewaysSize < 1) {
+        fprintf(stderr, "usage: %s [nodes >= 2] [sidewaysNodes >= 1]\n"
+                , argv[0]);
+        return 1;
+    }
+    runShape(size, sidewaysSize, RIGHT_PATH, "right path");
+    runShape(size, sidewaysSize, LEFT_PATH, "left path");
+    runShape(size, sidewaysSize, ZIGZAG_PATH, "zigzag path");
+    puts(failed ? "FAILED" : "passed");
+    return failed ? 1 : 0;
+}
@@ -1,7 +1,157 @@
+#ifndef BINTREE_H
+#define BINTREE_H
+
 #include "nodedata.h"
+#include "nodepool.h"
+#include "frozentree.h"
+#include "bintreestats.h"
+#include "blockbuffer.h"
+#include <vector>
+#include <atomic>
+#include <functional>
+#include <iterator>
+#include <cstddef>
+#include <stdint.h>
+#include <type_traits>
 
 // buildTree and initArray REMAIN IN MAIN METHOD BECAUSE THEY ARE GLOBAL.
 
+/* This struct, KeyPrefix, turns a value into a number whose order agrees
+ * with the value's own order under <: if one prefix is less than another,
+ * so is its value. Equal prefixes say nothing, and the values themselves
+ * have to be compared. A BasicBinTree with the default Compare keeps the
+ * prefix of every NodeData in its Node and compares prefixes first, so most
+ * levels of a search cost one integer compare.
+ *
+ * Only a type whose KeyPrefix is ENABLED gets one. A std::string is, with
+ * its first 8 bytes read as a big-endian number, which is how string orders
+ * them. NodeData is not: its only way to its bytes is its output operator,
+ * and writing the text of every target costs more than the compares it
+ * would save. Any other type can opt in by specializing KeyPrefix.
+ * */
+template <class T>
+struct KeyPrefix {
+    static const bool ENABLED = false;
+    static uint64_t of(const T&) { return 0; }
+};
+
+template <>
+struct KeyPrefix<string> {
+    static const bool ENABLED = true;
+    static uint64_t of(const string& text) {
+        uint64_t prefix = 0;
+        for (size_t i = 0; i < 8; i++) {
+            prefix <<= 8;
+            if (i < text.size()) {
+                prefix |= static_cast<unsigned char>(text[i]);
+            }
+        }
+        return prefix;
+    }
+};
+
+
+/* This struct, NodePrefix, is where a Node keeps its KeyPrefix. A Node
+ * whose BasicBinTree keeps none gets the empty version and no extra bytes.
+ * */
+template <bool STORED>
+struct NodePrefix {
+    uint64_t prefix;                        // KeyPrefix of the NodeData
+    void setPrefix(uint64_t value) { prefix = value; }
+    uint64_t getPrefix() const { return prefix; }
+};
+
+template <>
+struct NodePrefix<false> {
+    void setPrefix(uint64_t) {}
+    uint64_t getPrefix() const { return 0; }
+};
+
+
+//---------------------------compareKeys---------------------------------------
+// Three-way order of two values under <: negative, zero or positive. A
+// string is compared in one pass instead of two.
+template <class T>
+inline int compareKeys(const T& first, const T& second) {
+    return first < second ? -1 : (second < first ? 1 : 0);
+}
+
+inline int compareKeys(const string& first, const string& second) {
+    return first.compare(second);
+}
+
+
+/* This struct, BinTreeKey, says how a BasicBinTree holds its Keys.
+ *
+ * By default a Key is stored by value inside its Node, so finding it costs
+ * no load beyond the Node itself. Lookups take a Key, iterators show one, and
+ * copying the tree copies the Keys in place. A std::string Key keeps a short
+ * string (up to 15 chars with libstdc++) inside itself, so each of those
+ * Nodes needs no allocation of its own.
+ *
+ * BinTreeKey<NodeData*> keeps the contract BinTree has always had: the Node
+ * holds a pointer to a NodeData that the tree owns, lookups take a NodeData,
+ * retrieve() hands that same pointer back, a copy of the tree is made of new
+ * NodeData, and every NodeData is deleted with the tree.
+ * */
+template <class Key>
+struct BinTreeKey {
+    typedef Key value_type;                 // what lookups take
+    typedef const Key* pointer;             // what retrieve() hands back
+    static const bool OWNS = false;         // dispose() does nothing
+
+    // The value a Key stands for, and where it is.
+    static const value_type& value(const Key& key) { return key; }
+    static pointer address(const Key& key) { return &key; }
+
+    // Three-way order of two values under <, used on KeyPrefix ties.
+    static int compare(const value_type& first, const value_type& second) {
+        return compareKeys(first, second);
+    }
+
+    // A new Key equal to key, or built from the text writeBinary() wrote.
+    static Key copy(const Key& key) { return key; }
+    static Key fromString(const string& text) { return Key(text); }
+
+    // Frees whatever key owns before it is destroyed, and empties a Key
+    // that was moved from or not found.
+    static void dispose(Key&) {}
+    static void clear(Key&) {}
+};
+
+template <>
+struct BinTreeKey<NodeData*> {
+    typedef NodeData value_type;
+    typedef NodeData* pointer;
+    static const bool OWNS = true;
+
+    static const NodeData& value(const NodeData* key) { return *key; }
+    static NodeData* address(NodeData* key) { return key; }
+
+    // NodeData only has two-way operators.
+    static int compare(const NodeData& first, const NodeData& second) {
+        return first < second ? -1 : (second < first ? 1 : 0);
+    }
+
+    static NodeData* copy(const NodeData* key) { return new NodeData(*key); }
+    static NodeData* fromString(const string& text) {
+        return new NodeData(text);
+    }
+
+    static void dispose(NodeData*& key) { delete key; }
+    static void clear(NodeData*& key) { key = NULL; }
+};
+
+
+template <class Key, class Compare = less<typename BinTreeKey<Key>::value_type>
+        , class Allocator = NodePool>
+class BasicBinTree;
+
+template <class Key, class Compare, class Allocator>
+ostream& operator<<(ostream& outStream
+        , const BasicBinTree<Key, Compare, Allocator>& otherTree);
+
+
 /* This class, BinTree, is a Binary tree that follows the Binary Search
  * algorithm. The lesser value Nodes go to the left, while the greater
  * value Nodes go to the right.
@@ -13,97 +163,434 @@
  * BinTree and can retrieve the desired Node data. Additionally, BinTree can
  * return the position of a Node relative to the bottom of the BinTree.
  *
+ * A BinTree can optionally be created in balanced mode, in which case it
+ * keeps itself AVL balanced on every insert and remove so that its height
+ * stays O(log n) no matter what order the data arrives in. Otherwise remove
+ * rebuilds the highest subtree on its path that has grown much taller than
+ * its size needs, so deletes keep the BinTree shallow at an amortized cost.
+ *
+ * Nodes are carved from a NodePool owned by the BinTree instead of being
+ * allocated one at a time, so emptying the BinTree frees whole blocks.
+ *
+ * None of the methods recurse on the shape of the tree. Every walk keeps its
+ * own stack on the heap, so a BinTree that has degenerated into a long list
+ * can still be printed, copied, compared and destroyed.
+ *
+ * Copying, comparing and emptying a large BinTree split the work across
+ * threads by subtree, up to about one task per hardware thread.
+ *
+ * Two BinTrees can be split, joined, and combined by union, intersection or
+ * difference without copying a NodeData, using join-based algorithms that
+ * rearrange the Nodes themselves.
+ *
+ * Every Node also points back at its parent, so a const_iterator can walk
+ * the BinTree in order without a stack, and begin(), lower_bound() and
+ * upper_bound() let a range be scanned in O(log n + k).
+ *
+ * shapeReport() describes how deep and how balanced the BinTree is. When
+ * compiled with BINTREE_STATS defined, insert, retrieve, getHeight and remove
+ * also count their comparisons, visits and allocations and time themselves;
+ * stats() returns the totals.
+ *
+ * BinTree is BasicBinTree<NodeData*>. Any other Key is stored by value in
+ * its Node (see BinTreeKey), so a search compares against the Node it has
+ * just loaded instead of following one more pointer to a NodeData, and a
+ * copy copies Keys instead of allocating NodeData. Compare orders the Keys'
+ * values; it is default constructed wherever two are compared, so it must
+ * not need any state. It must not throw either: insertBatch() holds every
+ * NodeData outside the BinTree while it merges, and would lose them.
+ * With the default Compare and a value_type that has a KeyPrefix, such as
+ * std::string, every Node also keeps the prefix of its NodeData, and
+ * searches compare it before the NodeData itself. Allocator is where the
+ * Nodes come from: NodePool, or any class with the same members. In the
+ * comments of this class, NodeData means value_type: NodeData in a BinTree,
+ * the Key itself otherwise.
  * */
-class BinTree {
+template <class Key, class Compare, class Allocator>
+class BasicBinTree {
+
+friend ostream& operator<< <>(ostream& outStream
+        , const BasicBinTree& otherTree);
+
+// Builds list-shaped BinTrees directly, which insert() can only do in
+// O(n^2), for bench/bintreestress.cpp.
+friend class BinTreeStress;
+
 
-friend ostream& operator<<(ostream& outStream, const BinTree& otherTree);
+public:
+    typedef Key key_type;                   // what a Node holds
+    typedef typename BinTreeKey<Key>::value_type value_type;
+    typedef typename BinTreeKey<Key>::pointer data_pointer;
 
 
 private:
-    struct Node {
-        NodeData* data;						// pointer to data object
+    typedef BinTreeKey<Key> KeyTraits;
+
+    // Nodes keep a KeyPrefix only under the default Compare, whose order it
+    // follows.
+    static const bool USE_PREFIX = KeyPrefix<value_type>::ENABLED
+            && is_same<Compare, less<value_type> >::value;
+
+    struct Node : NodePrefix<USE_PREFIX> {
+        Key data;							// data object, or pointer to it
         Node* left;							// left subtree pointer
         Node* right;						// right subtree pointer
+        Node* parent;						// NULL for the root
+        int height;							// height of this subtree
+        int size;							// Nodes in this subtree
     };
     Node* root;                             // root of the tree
+    bool balanced;                          // AVL balancing on insert
+    Allocator pool;                         // memory for every Node
+    vector<Node**> insertPath;              // reused by insert and remove
+#ifdef BINTREE_STATS
+    mutable OperationCounters insertCounters;
+    mutable OperationCounters retrieveCounters;
+    mutable OperationCounters heightCounters;
+    mutable OperationCounters removeCounters;
+#endif
+
+    // A batch is merged into the BinTree with one in-order pass and a
+    // rebuild when the BinTree holds fewer than this many Nodes per batch
+    // entry.
+    static const int BATCH_REBUILD_RATIO = 4;
+
+    // How many lookups retrieveBatch() moves down the BinTree side by side.
+    static const int BATCH_LOOKUPS = 8;
+
+    // Subtrees smaller than this are never split across threads; starting a
+    // thread would cost more than the work it takes over.
+    static const int PARALLEL_MIN_NODES = 32 * 1024;
+
+    // In an unbalanced BinTree, remove() rebuilds a subtree on its path once
+    // it is more than this many times as tall as a balanced subtree of its
+    // size.
+    static const int REBUILD_HEIGHT_FACTOR = 2;
+
+
+    //----------------------------InorderWalk----------------------------------
+    // Hands out the Nodes of a subtree in order, one per call to next(),
+    // using an explicit stack instead of recursion. next() returns NULL once
+    // every Node has been visited.
+    class InorderWalk {
+    public:
+        explicit InorderWalk(Node* startPtr);
+        Node* next();
+    private:
+        vector<Node*> stack;                // Nodes whose left side is done
+        void pushLeft(Node* currentPtr);
+    };
+
+
+    //----------------------------IndexLess / TargetLess-----------------------
+    // Order the positions of a batch of Keys, or of an array of pointers to
+    // targets, by value, so the batch can be sorted without moving it.
+    struct IndexLess;
+    struct TargetLess;
+
+
+    //----------------------------keyLess / nodeValue--------------------------
+    // Compares two values with Compare, and returns the value a Node holds.
+    static bool keyLess(const value_type& first, const value_type& second);
+    static const value_type& nodeValue(const Node* nodePtr);
+
+
+    //----------------------------prefixOf / compareNode / searchOrder---------
+    // The KeyPrefix of a value, or 0 if Nodes keep none. compareNode() orders
+    // a Node's NodeData against target exactly. searchOrder() does the same
+    // with a prefix, and otherwise only tells less from not less with one
+    // comparison, leaving equality to be checked at the bottom.
+    static uint64_t prefixOf(const value_type& value);
+    static int compareNode(const Node* nodePtr, const value_type& target
+            , uint64_t targetPrefix);
+    static int searchOrder(const Node* nodePtr, const value_type& target
+            , uint64_t targetPrefix);
+
+
+    //----------------------------prefetch-------------------------------------
+    // Asks the CPU to start loading address into cache.
+    static void prefetch(const void* address);
+
+
+    //----------------------------newNode--------------------------------------
+    // Takes a Node from the pool (or from nodePool) and makes it a leaf
+    // holding data.
+    Node* newNode(Key data);
+    static Node* newNode(Key data, Allocator& nodePool);
+
+
+    //----------------------------freeNode-------------------------------------
+    // Destroys the Node, whose Key must not own anything any more, and gives
+    // it back to nodePool.
+    static void freeNode(Node* nodePtr, Allocator& nodePool);
+
+
+    //----------------------------shouldFork-----------------------------------
+    // Returns true if the subtree at currentPtr, depth levels below where
+    // the work started, is big enough to hand half of it to another thread.
+    static bool shouldFork(const Node* currentPtr, int depth);
 
 
     //----------------------------outputHelper---------------------------------
-    // Helper for output overloaded operator. Prints the BinTree's data in
-    // an in-order fashion
+    // Helper for output overloaded operator and outputToFd(). Prints the
+    // BinTree's data to outStream in an in-order fashion. Uses InorderWalk
     void outputHelper(ostream& outStream, const Node* currentPtr ) const;
 
 
     //--------------------------sideways----------------------------------------
     // Helper for displaySideways(). Displays BinTree's structure sideways.
-    void sideways(Node*, int) const;
+    void sideways(ostream&, Node*, int) const;
 
 
     // ----------------------------insertHelper--------------------------------
     // Helper for insert() method.  Inserts the data into the BinTree.
     // Returns True is successful. Returns False if not successful
-    bool insertHelper(NodeData* s, Node*& current);
+    bool insertHelper(Key& s, Node*& current);
 
 
     //---------------------------destroyTree-----------------------------------
-    // Helper for Destructor and makeEmpty() methods. Deletes all Nodes and
-    // NodeData in BinTree. BinTree will be empty after.
-    void destroyTree(Node* currentPtr);
+    // Helper for Destructor and makeEmpty() methods. Deletes the NodeData in
+    // every Node. The Nodes themselves are freed with the pool.
+    void destroyTree(Node* currentPtr, int depth = 0);
 
 
     //---------------------------copyTree--------------------------------------
     // Helper for copy constructor and assignment operator. Creates a deep copy
-    // of the other BinTree.
-    void copyTree(const Node* otherPtr, Node*& currentPtr);
+    // of the other BinTree with Nodes taken from nodePool.
+    void copyTree(const Node* otherPtr, Node*& currentPtr, Allocator& nodePool
+            , int depth = 0);
 
 
     //---------------------------checkEqual------------------------------------
     // Helper for equal and unequal operator. Checks to see if every Node in
-    // both BinTrees are the same. Returns true if they are equal. Fale is not
-    bool checkEqual(const Node* otherPtr, const Node* thisPtr) const;
+    // both BinTrees are the same. Returns true if they are equal. False if
+    // not, and sets mismatch so that other threads can stop early.
+    bool checkEqual(const Node* otherPtr, const Node* thisPtr
+            , atomic<bool>& mismatch, int depth = 0) const;
+
+
+    //---------------------------nodeHeight------------------------------------
+    // Returns the cached height of the subtree at currentPtr. 0 if NULL.
+    static int nodeHeight(const Node* currentPtr);
+
+
+    //---------------------------nodeSize--------------------------------------
+    // Returns the number of Nodes in the subtree at currentPtr. 0 if NULL.
+    static int nodeSize(const Node* currentPtr);
+
+
+    //---------------------------updateNode------------------------------------
+    // Recomputes currentPtr's cached height and size from its two children
+    // and points both children's parent back at currentPtr.
+    static void updateNode(Node* currentPtr);
+
+
+    //---------------------------rotateLeft / rotateRight----------------------
+    // Rotates the subtree at currentPtr and points currentPtr at the new
+    // subtree root. Heights, sizes and parents are kept up to date.
+    static void rotateLeft(Node*& currentPtr);
+    static void rotateRight(Node*& currentPtr);
+
+
+    //---------------------------rebalance-------------------------------------
+    // Restores the AVL property at currentPtr after one of its subtrees grew
+    // or shrank by one level. Used by insertHelper and remove when the
+    // BinTree is balanced.
+    static void rebalance(Node*& currentPtr);
+
+
+    //---------------------------tooTall---------------------------------------
+    // Returns true if the subtree at currentPtr is more than
+    // REBUILD_HEIGHT_FACTOR times as tall as a balanced one of its size.
+    static bool tooTall(const Node* currentPtr);
+
+
+    //---------------------------rebuildSubtree--------------------------------
+    // Rebuilds the subtree at currentPtr balanced with toBSTreeHelper(),
+    // keeping its NodeData and its parent.
+    void rebuildSubtree(Node*& currentPtr);
+
+
+    //---------------------------prepareForJoin--------------------------------
+    // Rebuilds the BinTree if it is not balanced and tooTall(), so that the
+    // join-based helpers below only recurse O(log n) deep, or if it is not
+    // balanced and needAVL is true, so that it can be joined into a
+    // balanced BinTree.
+    void prepareForJoin(bool needAVL);
+
+
+    //---------------------------joinNodes-------------------------------------
+    // Returns a subtree holding left, then middle, then right, where every
+    // NodeData in left is less than middle's and every one in right is
+    // greater. Goes down the taller side until the heights are close,
+    // hangs middle there and rebalances on the way back up.
+    static Node* joinNodes(Node* left, Node* middle, Node* right);
+
+
+    //---------------------------joinPair--------------------------------------
+    // Same as joinNodes() without a middle Node. Uses the largest Node of
+    // left as the middle.
+    static Node* joinPair(Node* left, Node* right);
+
+
+    //---------------------------removeLast------------------------------------
+    // Takes the largest Node out of the subtree at currentPtr, points
+    // lastPtr at it and returns what is left, rejoined.
+    static Node* removeLast(Node* currentPtr, Node*& lastPtr);
+
+
+    //---------------------------splitNode-------------------------------------
+    // Splits the subtree at currentPtr into the Nodes less than key and the
+    // Nodes greater than key. Returns the Node equal to key, unlinked, or
+    // NULL.
+    static Node* splitNode(Node* currentPtr, const value_type& key
+            , Node*& lessPtr, Node*& greaterPtr);
 
 
-    //----------------------------heightHelper---------------------------------
-    // Helper for getHeight() method. Returns the height of the Node from the
-    // bottom of the BinTree.
-    int heightHelper(const Node* currentPtr) const;
+    //---------------------------unionNodes / intersectNodes / differenceNodes-
+    // Join-based set operations on two subtrees whose Nodes come from the
+    // same pool. Every Node of both is either in the returned subtree or,
+    // with its NodeData deleted, pushed onto freed for the caller to give
+    // back to the pool. Large subtrees are split across threads.
+    static Node* unionNodes(Node* thisPtr, Node* otherPtr
+            , vector<Node*>& freed, int depth);
+    static Node* intersectNodes(Node* thisPtr, Node* otherPtr
+            , vector<Node*>& freed, int depth);
+    static Node* differenceNodes(Node* thisPtr, Node* otherPtr
+            , vector<Node*>& freed, int depth);
+
+
+    //---------------------------bothHalves------------------------------------
+    // Runs operation on the two less halves and on the two greater halves,
+    // the greater ones on another thread if fork is true.
+    static void bothHalves(Node* (*operation)(Node*, Node*, vector<Node*>&
+            , int), Node* thisLess, Node* otherLess, Node* thisGreater
+            , Node* otherGreater, Node*& lessPtr, Node*& greaterPtr
+            , vector<Node*>& freed, int depth, bool fork);
+
+
+    //---------------------------discardNodes----------------------------------
+    // Deletes the NodeData of every Node under currentPtr and pushes the
+    // Nodes onto freed.
+    static void discardNodes(Node* currentPtr, vector<Node*>& freed);
+
+
+    //---------------------------moveNodes-------------------------------------
+    // Copies the Nodes of the subtree at currentPtr into toPool, moving
+    // their NodeData over, and gives the old Nodes back to fromPool.
+    static void moveNodes(Node*& currentPtr, Allocator& fromPool
+            , Allocator& toPool);
+
+
+    //---------------------------setOperation----------------------------------
+    // Shared driver for unionWith(), intersect() and difference(). Takes
+    // over otherTree's Nodes and runs operation on the two roots.
+    void setOperation(BasicBinTree& otherTree, Node* (*operation)(Node*, Node*
+            , vector<Node*>&, int));
 
 
     //---------------------------findNode--------------------------------------
     // Helper for retrieve() and getHeight() methods. Finds the Node in the
-    // BinTree that has a specific NodeData value. Returns true if the BinTree
-    // contains that NodeDat. Returns false if it does not contain it.
-    bool findNode(const NodeData &target, Node* currentPtr, Node*& targetPtr) const;
+    // BinTree that has a specific NodeData value by descending one side per
+    // comparison. Returns true if the BinTree contains that NodeData.
+    // Returns false if it does not contain it.
+    bool findNode(const value_type &target, Node* currentPtr
+            , Node*& targetPtr) const;
+
+
+    //---------------------------countBelow------------------------------------
+    // Returns how many NodeData are less than target, or less than or equal
+    // to it if inclusive is true.
+    int countBelow(const value_type& target, bool inclusive) const;
+
+
+    //---------------------------mergeBatch------------------------------------
+    // Helper for insertBatch(). Merges the sorted batch with every NodeData
+    // in the BinTree and rebuilds it balanced with toBSTreeHelper().
+    int mergeBatch(Key batch[], const vector<int>& order, bool inserted[]);
 
 
     //--------------------------toArrayHelper----------------------------------
     // Helper for bstreeToArray() method. Moves all of the data from the array
     // into the BinTree so that it is balanced on both sides.
-    void toArrayHelper(NodeData* arrayPtr[], Node* currentPtr, int& index);
+    void toArrayHelper(Key arrayPtr[], Node* currentPtr, int& index);
+
+
+    //--------------------------exportHelper-----------------------------------
+    // Helper for copyToArray(), copyToVector() and view(). Writes the
+    // subtree at currentPtr, in order, from index offset on, into copies
+    // (as new NodeData) or into view (as pointers), whichever is not NULL.
+    // Nothing at or past capacity is written.
+    void exportHelper(const Node* currentPtr, int offset, int capacity
+            , const value_type* view[], Key copies[], int depth) const;
 
 
     //---------------------------toBSTreeHelper--------------------------------
-    // Helper for arrayToBSTree() method. Moves the data from this BinTree into
-    // the array in pre-order fashion.
-    void toBSTreeHelper(NodeData* array[], int min, int max, Node*& currentPtr);
+    // Helper for arrayToBSTree() method. Builds a balanced subtree out of
+    // array[min..max] in one pass, moving each NodeData out of the array.
+    void toBSTreeHelper(Key array[], int min, int max, Node*& currentPtr);
 
 
 
 public:
 
+    //---------------------------const_iterator--------------------------------
+    // A bidirectional iterator over the NodeData in order. It follows parent
+    // pointers instead of keeping a stack, so it is just two pointers. Any
+    // change to the BinTree invalidates it.
+    class const_iterator {
+    public:
+        typedef bidirectional_iterator_tag iterator_category;
+        typedef typename BinTreeKey<Key>::value_type value_type;
+        typedef ptrdiff_t difference_type;
+        typedef const value_type* pointer;
+        typedef const value_type& reference;
+
+        const_iterator();
+        reference operator*() const;
+        pointer operator->() const;
+        const_iterator& operator++();
+        const_iterator operator++(int);
+        const_iterator& operator--();
+        const_iterator operator--(int);
+        bool operator==(const const_iterator&) const;
+        bool operator!=(const const_iterator&) const;
+
+    private:
+        friend class BasicBinTree;
+        const_iterator(const Node* nodePtr, const BasicBinTree* treePtr);
+        const Node* current;                // NULL at end()
+        const BasicBinTree* tree;           // for stepping back from end()
+    };
+    typedef const_iterator iterator;        // NodeData order must not change
+
+
     //---------------------------Empty Constructor-----------------------------
     // Creates an empty BinTree.
-    BinTree();
+    BasicBinTree();
+
+
+    //---------------------------Balanced Constructor--------------------------
+    // Creates an empty BinTree. If balanced is true, the BinTree keeps itself
+    // AVL balanced on every insert.
+    explicit BasicBinTree(bool balanced);
 
 
     // -------------------------Copy Constructor------------------------------
     // Creates a deep copy of another BinTree.
-    BinTree(const BinTree&);
+    BasicBinTree(const BasicBinTree&);
+
+
+    // -------------------------Move Constructor------------------------------
+    // Takes over every Node of another BinTree in O(1). The other BinTree is
+    // left empty. Never throws, so containers of BinTrees move them instead
+    // of copying them.
+    BasicBinTree(BasicBinTree&&) noexcept;
 
 
     // ---------------------------Destructor----------------------------------
     // Destroys tree and frees memory.  Calls private method destroyTree().
-    ~BinTree();
+    ~BasicBinTree();
 
 
     // ---------------------------isEmpty---------------------------------------
@@ -111,6 +598,35 @@ public:
     bool isEmpty() const;
 
 
+    // ---------------------------size------------------------------------------
+    // Returns the number of NodeData in the BinTree in O(1).
+    int size() const;
+
+
+    // ---------------------------rank------------------------------------------
+    // Returns how many NodeData in the BinTree are less than the target, in
+    // O(height). The target does not have to be in the BinTree.
+    int rank(const value_type &) const;
+
+
+    // ---------------------------select----------------------------------------
+    // Points the second argument at the NodeData with rank k (the smallest
+    // has rank 0) and returns true. Returns false and sets it to NULL if k
+    // is out of range.
+    bool select(int k, data_pointer &) const;
+
+
+    // ---------------------------countRange------------------------------------
+    // Returns how many NodeData are between low and high, both included, in
+    // O(height).
+    int countRange(const value_type &low, const value_type &high) const;
+
+
+    // ---------------------------isBalanced------------------------------------
+    // Returns true if this BinTree keeps itself AVL balanced on insert.
+    bool isBalanced() const;
+
+
     //---------------------------makeEmpty-------------------------------------
     // Makes BinTree empty. Calls private method destroyTree().
     void makeEmpty();
@@ -118,57 +634,244 @@ public:
 
     //------------------------------insert-------------------------------------
     // Inserts a Node into the BinTree that contains the NodeData. Calls
-    // private method insertHelper().
-    bool insert(NodeData* s);
+    // private method insertHelper(). A Key stored by value is copied in, or
+    // moved if it is a temporary.
+    bool insert(Key s);
+
+
+    //------------------------------remove-------------------------------------
+    // Takes the Node equal to the target out of the BinTree and hands its
+    // NodeData, which the caller now owns, back in the second argument.
+    // Returns false and sets it to NULL if the target is not there (a Key
+    // stored by value is left as it was).
+    bool remove(const value_type &, Key &);
+
+
+    // ---------------------------begin / end----------------------------------
+    // Returns an iterator to the smallest NodeData, and one past the largest.
+    const_iterator begin() const;
+    const_iterator end() const;
+
+
+    // ---------------------------lower_bound / upper_bound--------------------
+    // Returns an iterator to the first NodeData not less than (lower_bound)
+    // or greater than (upper_bound) the target, or end() if there is none.
+    // O(height).
+    const_iterator lower_bound(const value_type &) const;
+    const_iterator upper_bound(const value_type &) const;
+
+
+    // ---------------------------equal_range----------------------------------
+    // Returns lower_bound() and upper_bound() of the target together.
+    pair<const_iterator, const_iterator> equal_range(const value_type &)
+            const;
 
 
     // --------------------------displaySideways-------------------------------
     // Displays the BinTree sideways. Calls private method sideways()
     void displaySideways() const;
 
+
+    // --------------------------displaySideways-------------------------------
+    // Displays the BinTree sideways on outStream instead of cout.
+    void displaySideways(ostream& outStream) const;
+
+
+    // ---------------------------outputToFd-----------------------------------
+    // Writes the same text as the output operator straight to a file
+    // descriptor. Returns false if a write failed.
+    bool outputToFd(int fd) const;
+
+
+    // ---------------------------visitInorder---------------------------------
+    // Calls visit(data, context) on every NodeData in order. Leaves BinTree
+    // unchanged.
+    void visitInorder(void (*visit)(const value_type&, void*), void* context)
+            const;
+
     // -------------------------retrieve--------------------------------------
     // Returns true if NodeData is in BinTree. Returns false otherwise. Calls
     // private method findNode(). Leaves BinTree unchanged.
-    bool retrieve(const NodeData &, NodeData *&) const;
+    bool retrieve(const value_type &, data_pointer &) const;
+
+
+    //--------------------------insertBatch----------------------------------
+    // Inserts size NodeData at once. Sets inserted[i] (if not NULL) to what
+    // insert() would have returned for batch[i]. Returns how many were
+    // inserted. Large batches are merged in and the BinTree rebuilt balanced.
+    int insertBatch(Key batch[], int size, bool inserted[] = NULL);
+
+
+    //-------------------------retrieveBatch---------------------------------
+    // Looks up size NodeData at once. results[i] points at the match for
+    // targets[i], or is NULL. Returns how many were found. Leaves BinTree
+    // unchanged.
+    int retrieveBatch(const value_type* const targets[], int size
+            , data_pointer results[]) const;
 
     // --------------------------getHeight-----------------------------------
-    // Returns the height of the Node from the bottom of the BinTree. Calls
-    // private method findNode() and heightHelper(). Leaves BinTree unchanged
-    int getHeight(const NodeData &) const;
+    // Returns the height of the Node from the bottom of the BinTree in
+    // O(height). Calls private method findNode(). Leaves BinTree unchanged
+    int getHeight(const value_type &) const;
+
+
+    // --------------------------height--------------------------------------
+    // Returns the height of the whole BinTree in O(1). 0 if empty.
+    int height() const;
 
 
     //-----------------------------bsTreeToArray-------------------------------
     // Moves all of the data from the BinTree into the array. Calls private
     // method toArrayHelper() and makeEmpty()
-    void bstreeToArray(NodeData* []);
+    void bstreeToArray(Key []);
 
 
     //----------------------------arrayToBSTree--------------------------------
     // Moves the data from the array into the BinTree. Calls the private method
-    // to BSTreeHelper. Array is empty afterwards
-    void arrayToBSTree(NodeData* []);
+    // to BSTreeHelper. Array is empty afterwards. Only for pointer Keys.
+    void arrayToBSTree(Key []);
+
+
+    //----------------------------copyToArray----------------------------------
+    // Writes a copy of each NodeData, in order, into the array, stopping
+    // after capacity entries. The caller owns the copies. Returns how many
+    // were written. Leaves BinTree unchanged.
+    int copyToArray(Key [], int capacity) const;
+
+
+    //----------------------------copyToVector---------------------------------
+    // Replaces the vector's contents with a copy of every NodeData, in
+    // order. The caller owns the copies. Leaves BinTree unchanged.
+    void copyToVector(vector<Key>&) const;
+
+
+    //----------------------------view-----------------------------------------
+    // Same as copyToArray() and copyToVector(), but hands out read-only
+    // pointers to the NodeData in the BinTree instead of copies. They stay
+    // valid until the BinTree is changed.
+    int view(const value_type* [], int capacity) const;
+    void view(vector<const value_type*>&) const;
+
+
+    //----------------------------shapeReport----------------------------------
+    // Returns the size, height, average depth and balance factors of the
+    // BinTree in one O(n) walk, for spotting a BinTree that is degenerating.
+    ShapeReport shapeReport() const;
+
+
+#ifdef BINTREE_STATS
+    //----------------------------stats----------------------------------------
+    // Returns the counters for insert, retrieve, getHeight and remove.
+    BinTreeStats stats() const;
+
+
+    //----------------------------resetStats-----------------------------------
+    // Sets every counter back to 0.
+    void resetStats();
+#endif
+
+
+    //----------------------------freeze---------------------------------------
+    // Returns a read-only FrozenTree holding a copy of every NodeData, laid
+    // out for fast lookups. Leaves BinTree unchanged. Only for NodeData.
+    FrozenTree freeze() const;
+
+
+    //----------------------------writeBinary----------------------------------
+    // Writes every NodeData, in order, to a binary stream in the format
+    // MappedTree reads. Returns true if the stream is still good.
+    bool writeBinary(ostream&) const;
+
+
+    //----------------------------readBinary-----------------------------------
+    // Replaces this BinTree with the data written by writeBinary(), built
+    // balanced in one pass. Returns false, leaving it empty, if the stream
+    // does not hold a valid, sorted tree.
+    bool readBinary(istream&);
+
+
+    //----------------------------arrayToBSTree--------------------------------
+    // Moves the first size entries of a sorted array into the BinTree in
+    // O(size) without looking for a NULL at the end. If checkSorted is true,
+    // returns false and leaves the array alone when it is not strictly
+    // increasing. Array is empty afterwards.
+    bool arrayToBSTree(Key [], int size, bool checkSorted = false);
 
     // --------------------------Equal Operator-------------------------------
     // Checks if the two BinTrees are equal. Calls private method checkEqual()
     // to check every Node. Returns true if equal. Returns false if not
-    bool operator==(const BinTree &) const;
+    bool operator==(const BasicBinTree &) const;
 
     // -------------------------Unequal Operator----------------------------
     // Checks if the two BinTrees are equal. Negates the equal operator.
     // Returns true if unequal. Returns false if equal.
-    bool operator!=(const BinTree &) const;
+    bool operator!=(const BasicBinTree &) const;
 
     // -----------------------Assignment Operator--------------------------
     // Assigns this BinTree the same values as the other BinTree. Calls
     // private method destroyTree before assigning data so no memory leaks.
-    // returns a reference to this BinTree afterwards.
-    BinTree& operator=(const BinTree &);
+    // Does nothing if assigned to itself. Returns a reference to this
+    // BinTree afterwards.
+    BasicBinTree& operator=(const BasicBinTree &);
+
+
+    // -----------------------Move Assignment Operator---------------------
+    // Empties this BinTree, then takes over every Node of the other BinTree
+    // in O(1). The other BinTree is left empty. Returns this BinTree.
+    BasicBinTree& operator=(BasicBinTree &&) noexcept;
+
+
+    // ---------------------------swap--------------------------------------
+    // Exchanges the contents of this BinTree and another one in O(1).
+    void swap(BasicBinTree &) noexcept;
+
+
+    // ---------------------------split-------------------------------------
+    // Moves every NodeData greater than key into greater, which is emptied
+    // first, and keeps the ones less than key. A NodeData equal to key is
+    // taken out and handed back in the last argument, which the caller then
+    // owns, and true is returned; otherwise it is set to NULL and false is
+    // returned. Costs O(log n) plus the size of the smaller half, plus an
+    // O(n) rebuild if this BinTree is not balanced and has grown too tall,
+    // or greater is balanced and this BinTree is not.
+    bool split(const value_type &key, BasicBinTree &greater, Key &);
+
+
+    // ---------------------------join--------------------------------------
+    // Moves every NodeData of the other BinTree into this one, as long as
+    // all of them are greater, or all of them less, than every NodeData in
+    // this BinTree. Returns false, changing nothing, if not. The join itself
+    // is O(log n), but taking over the other BinTree's pool walks its free
+    // list, and a BinTree that is not balanced is first rebuilt in O(n) if
+    // it has grown too tall, or if it is the other one and this BinTree is
+    // balanced. If this BinTree is balanced, so is the result.
+    bool join(BasicBinTree &);
+
+
+    // ---------------------------unionWith / intersect / difference--------
+    // Replace this BinTree with its union, intersection or difference with
+    // the other BinTree, in O(m log(n / m + 1)) for sizes m <= n. Nodes are
+    // reused, never reallocated. Where both hold an equal NodeData, this
+    // BinTree's is kept. The other BinTree is left empty and every NodeData
+    // not kept is deleted. If this BinTree is balanced, the result is AVL
+    // balanced even if the other one was not, which then costs an O(m)
+    // rebuild of the other one first.
+    void unionWith(BasicBinTree &);
+    void intersect(BasicBinTree &);
+    void difference(BasicBinTree &);
 
 
 
 };
 
 
+// BinTree keeps the NodeData* interface it has always had. It is compiled
+// once, in bintree.cpp, instead of in every file that uses it.
+typedef BasicBinTree<NodeData*> BinTree;
 
+#include "bintree.tpp"
 
+extern template class BasicBinTree<NodeData*>;
+extern template ostream& operator<< <>(ostream&, const BinTree&);
 
+#endif
@@ -0,0 +1,2953 @@
+// Members of BasicBinTree. bintree.h includes this file at its end, since
+// every file using the template needs them; BinTree itself is instantiated
+// once, in bintree.cpp.
+
+#include "mappedtree.h"
+#include <algorithm>
+#include <climits>
+#include <cstring>
+#include <new>
+#include <sstream>
+#include <type_traits>
+#include <utility>
+#include <future>
+#include <thread>
+
+// With BINTREE_STATS defined, operations measure themselves with a
+// StatsProbe and the helpers they call report each comparison, visit and
+// allocation to it. Without it these expand to nothing. All four are
+// undefined again at the end of this file.
+#ifdef BINTREE_STATS
+#define STATS_PROBE(counters) StatsProbe statsProbe(counters)
+#define STATS_COMPARE() StatsProbe::compare()
+#define STATS_VISIT(depth) StatsProbe::visit(depth)
+#define STATS_ALLOCATE() StatsProbe::allocate()
+#else
+#define STATS_PROBE(counters)
+#define STATS_COMPARE() ((void)0)
+#define STATS_VISIT(depth) ((void)(depth))
+#define STATS_ALLOCATE() ((void)0)
+#endif
+
+
+template <class Key, class Compare, class Allocator>
+const int BasicBinTree<Key, Compare, Allocator>::BATCH_REBUILD_RATIO;
+
+template <class Key, class Compare, class Allocator>
+const int BasicBinTree<Key, Compare, Allocator>::BATCH_LOOKUPS;
+
+template <class Key, class Compare, class Allocator>
+const int BasicBinTree<Key, Compare, Allocator>::PARALLEL_MIN_NODES;
+
+template <class Key, class Compare, class Allocator>
+const int BasicBinTree<Key, Compare, Allocator>::REBUILD_HEIGHT_FACTOR;
+
+template <class Key, class Compare, class Allocator>
+const bool BasicBinTree<Key, Compare, Allocator>::USE_PREFIX;
+
+
+
+/*-------------------------------Private: prefetch-----------------------------
+ * Pre: Takes in a read-only pointer, address. May be NULL.
+ *
+ * Post: Asks the CPU to start loading address into cache. Does nothing on
+ *       compilers that do not support it.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+inline void BasicBinTree<Key, Compare, Allocator>::prefetch(
+        const void* address) {
+#if defined(__GNUC__)
+    __builtin_prefetch(address);
+#else
+    (void)address;
+#endif
+}
+
+
+
+/*-------------------------------Private: keyLess------------------------------
+ * Pre: Takes in two read-only values, first and second.
+ *
+ * Post: Returns true if Compare orders first before second.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+inline bool BasicBinTree<Key, Compare, Allocator>::keyLess(
+        const value_type& first, const value_type& second) {
+    return Compare()(first, second);
+}
+
+
+
+/*------------------------------Private: nodeValue-----------------------------
+ * Pre: Takes in a read-only pointer to a Node, nodePtr, that is not NULL.
+ *
+ * Post: Returns the NodeData nodePtr holds: the Key itself if it is stored
+ *       by value, or the NodeData it points to in a BinTree.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+inline const typename BasicBinTree<Key, Compare, Allocator>::value_type&
+        BasicBinTree<Key, Compare, Allocator>::nodeValue(const Node* nodePtr) {
+    return KeyTraits::value(nodePtr->data);
+}
+
+
+
+/*------------------------------Private: prefixOf------------------------------
+ * Pre: Takes in a read-only value, value.
+ *
+ * Post: Returns the KeyPrefix of value if Nodes keep one, or 0 otherwise.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+inline uint64_t BasicBinTree<Key, Compare, Allocator>::prefixOf(
+        const value_type& value) {
+    return USE_PREFIX ? KeyPrefix<value_type>::of(value) : 0;
+}
+
+
+
+/*-----------------------------Private: compareNode----------------------------
+ * Pre: Takes in a read-only pointer to a Node, nodePtr, that is not NULL.
+ *      Takes in a read-only value, target, and targetPrefix, which is
+ *      prefixOf(target).
+ *
+ * Post: Returns a negative number if nodePtr's NodeData is less than target,
+ *       0 if it is equal and a positive number if it is greater. If Nodes
+ *       keep a prefix, a tie on it is settled with one three-way compare.
+ *       Otherwise Compare is called once, or twice if the first call finds
+ *       the NodeData is not less.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+inline int BasicBinTree<Key, Compare, Allocator>::compareNode(
+        const Node* nodePtr, const value_type& target, uint64_t targetPrefix) {
+    if (USE_PREFIX) {
+        uint64_t nodePrefix = nodePtr->getPrefix();
+        if (nodePrefix != targetPrefix) {
+            return nodePrefix < targetPrefix ? -1 : 1;
+        }
+        return KeyTraits::compare(nodeValue(nodePtr), target);
+    }
+    if (keyLess(nodeValue(nodePtr), target)) {
+        return -1;
+    }
+    return keyLess(target, nodeValue(nodePtr)) ? 1 : 0;
+}
+
+
+
+/*-----------------------------Private: searchOrder----------------------------
+ * Pre: Takes in a read-only pointer to a Node, nodePtr, that is not NULL.
+ *      Takes in a read-only value, target, and targetPrefix, which is
+ *      prefixOf(target).
+ *
+ * Post: If Nodes keep a prefix, returns compareNode(). Otherwise calls
+ *       Compare once and returns -1 if nodePtr's NodeData is less than
+ *       target and 1 if it is not, so a descent that never sees 0 has to
+ *       check its last candidate for equality itself.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+inline int BasicBinTree<Key, Compare, Allocator>::searchOrder(
+        const Node* nodePtr, const value_type& target, uint64_t targetPrefix) {
+    if (USE_PREFIX) {
+        return compareNode(nodePtr, target, targetPrefix);
+    }
+    return keyLess(nodeValue(nodePtr), target) ? -1 : 1;
+}
+
+
+
+/*-------------------------------Private: IndexLess----------------------------
+ * Orders positions of an array of Keys by the NodeData they stand for, so a
+ * batch can be sorted without moving it.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+struct BasicBinTree<Key, Compare, Allocator>::IndexLess {
+    const Key* items;
+    explicit IndexLess(const Key* items) : items(items) {}
+    bool operator()(int first, int second) const {
+        return keyLess(KeyTraits::value(items[first])
+                , KeyTraits::value(items[second]));
+    }
+};
+
+
+
+/*------------------------------Private: TargetLess----------------------------
+ * Orders positions of an array of NodeData pointers by the NodeData they
+ * point to, so the targets of retrieveBatch() can be sorted without moving
+ * them.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+struct BasicBinTree<Key, Compare, Allocator>::TargetLess {
+    const value_type* const* items;
+    explicit TargetLess(const value_type* const* items) : items(items) {}
+    bool operator()(int first, int second) const {
+        return keyLess(*items[first], *items[second]);
+    }
+};
+
+
+
+/*-----------------------------Empty Constructor-------------------------------
+ * Pre: None
+ *
+ * Post: Creates an empty BinTree.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+BasicBinTree<Key, Compare, Allocator>::BasicBinTree() : pool(sizeof(Node)) {
+    root = NULL;
+    balanced = false;
+}
+
+
+
+/*-----------------------------Balanced Constructor----------------------------
+ * Pre: Takes in a bool, balanced, which is true if this BinTree should keep
+ *      itself AVL balanced.
+ *
+ * Post: Creates an empty BinTree. When balanced is true, every insert
+ *       rotates the BinTree as needed so its height stays O(log n) even when
+ *       the data is inserted in sorted order.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+BasicBinTree<Key, Compare, Allocator>::BasicBinTree(bool balanced)
+        : pool(sizeof(Node)) {
+    root = NULL;
+    this->balanced = balanced;
+}
+
+
+
+/* ------------------------------Copy Constructor------------------------------
+ * Pre: Takes in a read-only reference to another BinTree, otherTree.
+ *
+ * Post: Creates a deep copy of otherTree. Meaning that this BinTree is the
+ *      exact same as otherTree, but it is its own tree.
+ * */
+template <class Key, class Compare, class Allocator>
+BasicBinTree<Key, Compare, Allocator>::BasicBinTree(
+        const BasicBinTree& otherTree) : pool(sizeof(Node)) {
+    root = NULL;
+    balanced = otherTree.balanced;
+    copyTree(otherTree.root, root, pool);
+}
+
+
+
+/* ------------------------------Move Constructor------------------------------
+ * Pre: Takes in a reference to a BinTree, otherTree, that is about to go
+ *      away.
+ *
+ * Post: This BinTree takes over otherTree's Nodes, data and NodePool in
+ *       O(1) without copying anything. otherTree is left empty.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+BasicBinTree<Key, Compare, Allocator>::BasicBinTree(BasicBinTree&& otherTree)
+        noexcept : pool(sizeof(Node)) {
+    root = NULL;
+    balanced = false;
+    swap(otherTree);
+}
+
+
+
+/*---------------------------------Destructor----------------------------------
+ * Pre: None
+ *
+ * Post: Destroys this BinTree by deleting everything in the tree. The BinTree
+ *       will be NULL.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+BasicBinTree<Key, Compare, Allocator>::~BasicBinTree() {
+    makeEmpty();
+}
+
+
+
+/*---------------------------------CopyTree------------------------------------
+ * Pre: Takes in a read-only pointer to a Node in another BinTree, otherPtr
+ *      Takes in a reference pointer, currentPtr, which points to a Node in
+ *      this BinTree. Takes in a reference to a NodePool, nodePool, to take
+ *      the new Nodes from. Takes in an int, depth, which is how many times
+ *      the copy has already been split across threads.
+ *
+ * Post: Copies this BinTree to be an exact copy of the other BinTree. While
+ *       shouldFork() allows it, the right subtree is copied by another
+ *       thread into a NodePool of its own, which is spliced into nodePool
+ *       once it is done. Smaller subtrees are copied with an explicit stack.
+ *       The copied subtree's root is left with a NULL parent.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::copyTree(const Node* otherPtr
+        , Node*& currentPtr, Allocator& nodePool, int depth) {
+    if (shouldFork(otherPtr, depth)) {
+        currentPtr = newNode(KeyTraits::copy(otherPtr->data), nodePool);
+        currentPtr->height = otherPtr->height;
+        currentPtr->size = otherPtr->size;
+        Allocator rightPool(sizeof(Node));
+        future<void> rightCopy = async(launch::async
+                , &BasicBinTree::copyTree, this, otherPtr->right
+                , ref(currentPtr->right), ref(rightPool), depth + 1);
+        copyTree(otherPtr->left, currentPtr->left, nodePool, depth + 1);
+        rightCopy.get();
+        nodePool.splice(rightPool);
+        updateNode(currentPtr);             // point both halves back up
+        return;
+    }
+
+    // Each entry is the Node to copy, where to link the copy, and the copy's
+    // parent.
+    vector<pair<const Node*, pair<Node**, Node*> > > stack;
+    stack.push_back(make_pair(otherPtr, make_pair(&currentPtr
+            , static_cast<Node*>(NULL))));
+    while (!stack.empty()) {
+        const Node* fromPtr = stack.back().first;
+        Node** linkPtr = stack.back().second.first;
+        Node* parentPtr = stack.back().second.second;
+        stack.pop_back();
+        if (fromPtr != NULL) {
+            Node* copyPtr = newNode(KeyTraits::copy(fromPtr->data), nodePool);
+            copyPtr->parent = parentPtr;
+            copyPtr->height = fromPtr->height;
+            copyPtr->size = fromPtr->size;
+            *linkPtr = copyPtr;
+            stack.push_back(make_pair(fromPtr->right
+                    , make_pair(&copyPtr->right, copyPtr)));
+            stack.push_back(make_pair(fromPtr->left
+                    , make_pair(&copyPtr->left, copyPtr)));
+        }
+    }
+}
+
+
+
+/*----------------------------Private: shouldFork------------------------------
+ * Pre: Takes in a read-only pointer to a Node, currentPtr, or NULL. Takes in
+ *      an int, depth, which is how many times the work has been split.
+ *
+ * Post: Returns true if currentPtr's subtree has at least PARALLEL_MIN_NODES
+ *       Nodes and splitting it again still leaves no more tasks than about
+ *       one per hardware thread. Returns false otherwise.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::shouldFork(const Node* currentPtr
+        , int depth) {
+    static const int maxDepth = []() {
+        unsigned threads = thread::hardware_concurrency();
+        int levels = 0;
+        while ((1u << levels) < threads) {
+            levels++;
+        }
+        return levels;
+    }();
+    return depth < maxDepth && nodeSize(currentPtr) >= PARALLEL_MIN_NODES;
+}
+
+
+
+/* -----------------------------Output Operator--------------------------------
+ * Pre: Takes in a reference to an ostream, outStream, which is used to write
+ *      the output. Takes in a read-only reference to another BinTree,
+ *      otherTree, which is going to be the tree printed.
+ *
+ * Post: Prints the BinTree out to outStream in an in-order traversal. This
+ *      will print it out alphabetically. The text is collected in a
+ *      BlockBuffer and handed to outStream a block at a time, formatted with
+ *      outStream's locale and flags. Returns the ostream after every BinTree
+ *      node has been printed.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+ostream& operator<<(ostream& outStream
+        , const BasicBinTree<Key, Compare, Allocator>& otherTree) {
+    {
+        BlockBuffer buffer(outStream);
+        ostream blockStream(&buffer);
+        blockStream.copyfmt(outStream);
+        blockStream.tie(NULL);
+        otherTree.outputHelper(blockStream, otherTree.root);
+    }
+    outStream << endl;
+    return outStream;
+}
+
+
+
+/*--------------------------------outputToFd-----------------------------------
+ * Pre: Takes in an int, fd, which is a file descriptor open for writing.
+ *
+ * Post: Writes the same text as the output operator to fd a block at a time
+ *       with write(), without going through any iostream. Returns true if
+ *       every write succeeded. Returns false otherwise. BinTree remains
+ *       unchanged.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::outputToFd(int fd) const {
+    BlockBuffer buffer(fd);
+    ostream blockStream(&buffer);
+    outputHelper(blockStream, root);
+    blockStream << '\n';
+    blockStream.flush();
+    return buffer.good();
+}
+
+
+
+/*-------------------------------visitInorder----------------------------------
+ * Pre: Takes in a pointer to a function, visit, that takes a read-only
+ *      NodeData and a context pointer. Takes in a pointer, context, which is
+ *      passed to visit untouched.
+ *
+ * Post: Calls visit once for each NodeData, in order, so the caller can send
+ *       the data anywhere without going through an ostream. BinTree remains
+ *       unchanged. visit must not change the BinTree.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::visitInorder(
+        void (*visit)(const value_type&, void*), void* context) const {
+    InorderWalk walk(root);
+    for (Node* nodePtr = walk.next(); nodePtr != NULL; nodePtr = walk.next()) {
+        visit(nodeValue(nodePtr), context);
+    }
+}
+
+
+
+/*------------------------Private: OutputHelper-------------------------------
+ * Pre: Takes in a reference to an ostream, outStream, which is used to print
+ *      the data to the console. Takes in a read-only pointer to a Node,
+ *      currentPtr, which points to a Node within the BinTree that will be
+ *      printed.
+ *
+ * Post: Is a read-only method. Prints the data to outStream in an in-order
+ *       traversal.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::outputHelper(ostream& outStream
+        , const Node* currentPtr) const {
+    InorderWalk walk(const_cast<Node*>(currentPtr));
+    for (Node* nodePtr = walk.next(); nodePtr != NULL; nodePtr = walk.next()) {
+        outStream << nodeValue(nodePtr) << ' ';
+    }
+}
+
+
+
+/*----------------------------InorderWalk Constructor--------------------------
+ * Pre: Takes in a pointer to a Node, startPtr, which is the root of the
+ *      subtree to walk. May be NULL.
+ *
+ * Post: Sets up the walk so that the first call to next() returns the
+ *       smallest Node under startPtr.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+BasicBinTree<Key, Compare, Allocator>::InorderWalk::InorderWalk(
+        Node* startPtr) {
+    pushLeft(startPtr);
+}
+
+
+
+/*-------------------------------InorderWalk::next-----------------------------
+ * Pre: None.
+ *
+ * Post: Returns the next Node in order, or NULL when there are no Nodes
+ *       left. The Node returned may be changed but the links must not be.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::Node*
+        BasicBinTree<Key, Compare, Allocator>::InorderWalk::next() {
+    if (stack.empty()) {
+        return NULL;
+    }
+    Node* currentPtr = stack.back();
+    stack.pop_back();
+    pushLeft(currentPtr->right);
+    return currentPtr;
+}
+
+
+
+/*---------------------------InorderWalk::pushLeft-----------------------------
+ * Pre: Takes in a pointer to a Node, currentPtr, or NULL.
+ *
+ * Post: Pushes currentPtr and every Node down its left spine onto the stack.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::InorderWalk::pushLeft(
+        Node* currentPtr) {
+    while (currentPtr != NULL) {
+        stack.push_back(currentPtr);
+        currentPtr = currentPtr->left;
+    }
+}
+
+
+
+/*---------------------------const_iterator Constructor------------------------
+ * Pre: None.
+ *
+ * Post: Creates an iterator that does not belong to any BinTree.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+BasicBinTree<Key, Compare, Allocator>::const_iterator::const_iterator()
+        : current(NULL), tree(NULL) {
+}
+
+
+
+/*---------------------------const_iterator Constructor------------------------
+ * Pre: Takes in a read-only pointer to a Node, nodePtr, in the BinTree that
+ *      treePtr points to, or NULL for end().
+ *
+ * Post: Creates an iterator at nodePtr.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+BasicBinTree<Key, Compare, Allocator>::const_iterator::const_iterator(
+        const Node* nodePtr, const BasicBinTree* treePtr)
+        : current(nodePtr), tree(treePtr) {
+}
+
+
+
+/*---------------------------const_iterator::operator*-------------------------
+ * Pre: The iterator is not at end().
+ *
+ * Post: Returns a read-only reference to the NodeData it is at.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::const_iterator::reference
+        BasicBinTree<Key, Compare, Allocator>::const_iterator::operator*()
+        const {
+    return nodeValue(current);
+}
+
+
+
+/*---------------------------const_iterator::operator->------------------------
+ * Pre: The iterator is not at end().
+ *
+ * Post: Returns a read-only pointer to the NodeData it is at.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::const_iterator::pointer
+        BasicBinTree<Key, Compare, Allocator>::const_iterator::operator->()
+        const {
+    return &nodeValue(current);
+}
+
+
+
+/*---------------------------const_iterator::operator++------------------------
+ * Pre: The iterator is not at end().
+ *
+ * Post: Moves to the next NodeData in order, or to end() after the largest.
+ *       Goes down to the smallest Node of the right subtree if there is
+ *       one, otherwise up until it comes from a left child. Returns the
+ *       iterator.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::const_iterator&
+        BasicBinTree<Key, Compare, Allocator>::const_iterator::operator++() {
+    if (current->right != NULL) {
+        current = current->right;
+        while (current->left != NULL) {
+            current = current->left;
+        }
+    } else {
+        const Node* childPtr = current;
+        current = current->parent;
+        while (current != NULL && current->right == childPtr) {
+            childPtr = current;
+            current = current->parent;
+        }
+    }
+    return *this;
+}
+
+
+
+/*---------------------------const_iterator::operator++(int)-------------------
+ * Pre: The iterator is not at end().
+ *
+ * Post: Moves to the next NodeData in order. Returns where it was before.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::const_iterator
+        BasicBinTree<Key, Compare, Allocator>::const_iterator::operator++(int) {
+    const_iterator before = *this;
+    ++*this;
+    return before;
+}
+
+
+
+/*---------------------------const_iterator::operator--------------------------
+ * Pre: The iterator is not at begin().
+ *
+ * Post: Moves to the previous NodeData in order. From end() it moves to the
+ *       largest NodeData. Returns the iterator.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::const_iterator&
+        BasicBinTree<Key, Compare, Allocator>::const_iterator::operator--() {
+    if (current == NULL) {
+        current = tree->root;
+        while (current->right != NULL) {
+            current = current->right;
+        }
+    } else if (current->left != NULL) {
+        current = current->left;
+        while (current->right != NULL) {
+            current = current->right;
+        }
+    } else {
+        const Node* childPtr = current;
+        current = current->parent;
+        while (current != NULL && current->left == childPtr) {
+            childPtr = current;
+            current = current->parent;
+        }
+    }
+    return *this;
+}
+
+
+
+/*---------------------------const_iterator::operator--(int)-------------------
+ * Pre: The iterator is not at begin().
+ *
+ * Post: Moves to the previous NodeData in order. Returns where it was before.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::const_iterator
+        BasicBinTree<Key, Compare, Allocator>::const_iterator::operator--(int) {
+    const_iterator before = *this;
+    --*this;
+    return before;
+}
+
+
+
+/*---------------------------const_iterator::operator==------------------------
+ * Pre: Takes in a read-only reference to another iterator, other.
+ *
+ * Post: Returns true if both iterators are at the same Node (or both at
+ *       end() of the same BinTree). Returns false otherwise.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::const_iterator::operator==(
+        const const_iterator& other) const {
+    return current == other.current && tree == other.tree;
+}
+
+
+
+/*---------------------------const_iterator::operator!=------------------------
+ * Pre: Takes in a read-only reference to another iterator, other.
+ *
+ * Post: Negates the equal operator.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::const_iterator::operator!=(
+        const const_iterator& other) const {
+    return !(*this == other);
+}
+
+
+
+/*----------------------------------begin--------------------------------------
+ * Pre: None.
+ *
+ * Post: Returns an iterator at the smallest NodeData, or end() if the
+ *       BinTree is empty.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::const_iterator
+        BasicBinTree<Key, Compare, Allocator>::begin() const {
+    const Node* currentPtr = root;
+    while (currentPtr != NULL && currentPtr->left != NULL) {
+        currentPtr = currentPtr->left;
+    }
+    return const_iterator(currentPtr, this);
+}
+
+
+
+/*-----------------------------------end---------------------------------------
+ * Pre: None.
+ *
+ * Post: Returns an iterator one past the largest NodeData.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::const_iterator
+        BasicBinTree<Key, Compare, Allocator>::end() const {
+    return const_iterator(NULL, this);
+}
+
+
+
+/*-------------------------------lower_bound-----------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target.
+ *
+ * Post: Goes down one path from the root, remembering the last Node that was
+ *       not less than target. Returns an iterator at it, or end() if every
+ *       NodeData is less than target.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::const_iterator
+        BasicBinTree<Key, Compare, Allocator>::lower_bound(
+        const value_type& target) const {
+    const Node* currentPtr = root;
+    const Node* boundPtr = NULL;
+    while (currentPtr != NULL) {
+        if (keyLess(nodeValue(currentPtr), target)) {
+            currentPtr = currentPtr->right;
+        } else {
+            boundPtr = currentPtr;
+            currentPtr = currentPtr->left;
+        }
+    }
+    return const_iterator(boundPtr, this);
+}
+
+
+
+/*-------------------------------upper_bound-----------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target.
+ *
+ * Post: Goes down one path from the root, remembering the last Node that was
+ *       greater than target. Returns an iterator at it, or end() if no
+ *       NodeData is greater than target.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::const_iterator
+        BasicBinTree<Key, Compare, Allocator>::upper_bound(
+        const value_type& target) const {
+    const Node* currentPtr = root;
+    const Node* boundPtr = NULL;
+    while (currentPtr != NULL) {
+        if (keyLess(target, nodeValue(currentPtr))) {
+            boundPtr = currentPtr;
+            currentPtr = currentPtr->left;
+        } else {
+            currentPtr = currentPtr->right;
+        }
+    }
+    return const_iterator(boundPtr, this);
+}
+
+
+
+/*-------------------------------equal_range-----------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target.
+ *
+ * Post: Returns lower_bound(target) and upper_bound(target). The range holds
+ *       the NodeData equal to target, or is empty if there is none.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+pair<typename BasicBinTree<Key, Compare, Allocator>::const_iterator
+        , typename BasicBinTree<Key, Compare, Allocator>::const_iterator>
+        BasicBinTree<Key, Compare, Allocator>::equal_range(
+        const value_type& target) const {
+    return make_pair(lower_bound(target), upper_bound(target));
+}
+
+
+
+/*--------------------------------getHeight------------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target, which is used to
+ *      find a matching NodeData value in the BinTree.
+ *
+ * Post: Returns an int that is the height of the Node from the bottom of the
+ *      tree. (The Node contains the matching NodeData). The height is cached
+ *      in the Node, so this costs only the search. If the NodeData is not
+ *      in the BinTree, or the tree is empty, then 0 is returned.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+int BasicBinTree<Key, Compare, Allocator>::getHeight(const value_type& target)
+        const {
+    STATS_PROBE(heightCounters);
+    Node *targetPtr;
+    if (findNode(target, root, targetPtr)) {
+        return targetPtr->height;
+    }
+    targetPtr = NULL; // No dangling pointer.
+    return 0;
+}
+
+
+
+/*---------------------------------height--------------------------------------
+ * Pre: None.
+ *
+ * Post: Returns the height of the whole BinTree, read from the root. An
+ *       empty BinTree has a height of 0.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+int BasicBinTree<Key, Compare, Allocator>::height() const {
+    return nodeHeight(root);
+}
+
+
+
+/*------------------------------Private: findNode------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target, which is the
+ *      NodeData that is going to be searched for. Takes in a pointer to a
+ *      Node, currentPtr, which points to the current node in the BinTree.
+ *      Takes in a reference pointer to a Node, targetPtr, which will point to
+ *      the Node that contains target if found.
+ *
+ * Post: Searches the tree to see if it contains target. Follows the same
+ *       ordering as insertHelper, so only one side is visited per level.
+ *       Each level does a single < comparison and remembers the last Node
+ *       that was not less than target. Only that Node can be equal, so
+ *       equality is checked once at the bottom instead of once per level
+ *       with a second comparison. If Nodes keep a prefix, each level
+ *       compares the prefixes instead and only a tie compares the NodeData,
+ *       three-way, stopping as soon as one is equal. Both children are
+ *       prefetched at each level so that whichever one is taken is already
+ *       loading.
+ *       If it contains target, then targetPtr will point to the Node that
+ *       contains it and returns true. If target is not found, then
+ *       targetPtr is NULL and false is returned.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::findNode(const value_type &target
+        , Node* currentPtr, Node*& targetPtr) const {
+    Node* candidatePtr = NULL;          // last Node not less than target
+    uint64_t targetPrefix = prefixOf(target);
+    int depth = 0;
+    while (currentPtr != NULL) {
+        // Start loading both children while this NodeData is compared, so
+        // the next level only has to wait for its own NodeData.
+        prefetch(currentPtr->left);
+        prefetch(currentPtr->right);
+        depth++;
+        STATS_VISIT(depth);
+        STATS_COMPARE();
+        int order = searchOrder(currentPtr, target, targetPrefix);
+        if (order < 0) {
+            currentPtr = currentPtr->right;
+        } else if (order == 0) {
+            targetPtr = currentPtr;
+            return true;
+        } else {
+            candidatePtr = currentPtr;
+            currentPtr = currentPtr->left;
+        }
+    }
+    if (!USE_PREFIX && candidatePtr != NULL) {
+        STATS_COMPARE();
+        if (!keyLess(target, nodeValue(candidatePtr))) {
+            targetPtr = candidatePtr;
+            return true;
+        }
+    }
+    targetPtr = NULL;
+    return false;
+}
+
+
+
+/*-------------------------------retrieve-------------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target, which is the
+ *      value to look for. Takes in a pointer references to a NodeData,
+ *      nodeDataPtr.
+ *
+ * Post: Retrieves target's value from the tree. Makes nodeDataPtr point to
+ *       the Node that contains target's value in the BinTree. If target is
+ *       not in the tree, then the nodeDataPtr is set to NULL. If the target
+ *       if found, then returns true. If target is not in the BinTree, returns
+ *       false. **SETS nodeDataPtr TO NULL IF NOT FOUND.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::retrieve(const value_type &target
+        , data_pointer& nodeDataPtr) const {
+    STATS_PROBE(retrieveCounters);
+    Node* nodePtr;
+    if (findNode(target, root, nodePtr)) {
+        nodeDataPtr = KeyTraits::address(nodePtr->data);
+        nodePtr = NULL;
+        return true;
+    }
+    nodeDataPtr = NULL;  // NULL if not found in tree
+    nodePtr = NULL; //no dangling ptr
+    return false;
+}
+
+
+
+/*------------------------------insertBatch-----------------------------------
+ * Pre: Takes in an array of NodeData pointers, batch, that are not NULL and
+ *      are to be inserted. Takes in an int, size, which is the number of
+ *      entries in batch. Takes in an array of bools, inserted, with size
+ *      entries, or NULL.
+ *
+ * Post: Sorts the positions of batch by value (the array itself is left in
+ *       place) so the first of several equal entries is the one inserted.
+ *       If the BinTree is small compared to the batch, the two are merged
+ *       in one pass and the BinTree is rebuilt balanced by mergeBatch().
+ *       Otherwise the entries are inserted one by one in sorted order so
+ *       neighbouring searches share the same path. inserted[i] is set to
+ *       true if batch[i] is now owned by the BinTree, and to false if its
+ *       value was already there and the caller still owns it. Returns how
+ *       many entries were inserted. A Key stored by value is moved out of
+ *       batch when it is inserted.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+int BasicBinTree<Key, Compare, Allocator>::insertBatch(Key batch[], int size
+        , bool inserted[]) {
+    if (size <= 0) {
+        return 0;
+    }
+    vector<int> order(size);
+    for (int i = 0; i < size; i++) {
+        order[i] = i;
+    }
+    stable_sort(order.begin(), order.end(), IndexLess(batch));
+
+    if (nodeSize(root) < size * BATCH_REBUILD_RATIO) {
+        return mergeBatch(batch, order, inserted);
+    }
+
+    int count = 0;
+    for (int i = 0; i < size; i++) {
+        bool success = insertHelper(batch[order[i]], root);
+        if (inserted != NULL) {
+            inserted[order[i]] = success;
+        }
+        if (success) {
+            count++;
+        }
+    }
+    return count;
+}
+
+
+
+/*--------------------------Private: mergeBatch--------------------------------
+ * Pre: Takes in an array of NodeData pointers, batch. Takes in a read-only
+ *      vector of ints, order, which lists the positions of batch in sorted
+ *      order with equal entries in their original order. Takes in an array
+ *      of bools, inserted, or NULL. Compare must not throw.
+ *
+ * Post: Sets aside the memory the merge and the rebuild need, then moves
+ *       every NodeData out of the BinTree in order, frees the Nodes, and
+ *       merges them with the batch in one pass. A batch entry equal to
+ *       one already kept is left out and marked false in inserted. The
+ *       merged data is rebuilt into a balanced BinTree by toBSTreeHelper().
+ *       Returns how many batch entries were inserted.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+int BasicBinTree<Key, Compare, Allocator>::mergeBatch(Key batch[]
+        , const vector<int>& order, bool inserted[]) {
+    // Everything that can throw bad_alloc happens before the first Node is
+    // freed, so a failure leaves the BinTree as it was. The rebuild takes
+    // its Nodes from the free list: the old Nodes, and one spare slot per
+    // batch entry set aside here.
+    vector<Key> existing;
+    existing.reserve(nodeSize(root));
+    vector<Key> merged;
+    merged.reserve(nodeSize(root) + order.size());
+    vector<void*> spare;
+    spare.reserve(order.size());
+    for (size_t i = 0; i < order.size(); i++) {
+        spare.push_back(pool.allocate());
+    }
+    for (size_t i = 0; i < spare.size(); i++) {
+        pool.release(spare[i]);
+    }
+
+    InorderWalk walk(root);
+    for (Node* nodePtr = walk.next(); nodePtr != NULL; nodePtr = walk.next()) {
+        existing.push_back(std::move(nodePtr->data));
+        freeNode(nodePtr, pool);
+    }
+    root = NULL;
+
+    // Both lists are sorted, so an entry not less than the next existing one
+    // (or than the last one kept) is only equal to it if it is not greater.
+    size_t next = 0;
+    int count = 0;
+    for (size_t i = 0; i < order.size(); i++) {
+        Key& batchKey = batch[order[i]];
+        const value_type& batchValue = KeyTraits::value(batchKey);
+        while (next < existing.size()
+                && keyLess(KeyTraits::value(existing[next]), batchValue)) {
+            merged.push_back(std::move(existing[next]));
+            next++;
+        }
+        bool success = (next == existing.size()
+                || keyLess(batchValue, KeyTraits::value(existing[next])))
+                && (merged.empty()
+                || keyLess(KeyTraits::value(merged.back()), batchValue));
+        if (success) {
+            merged.push_back(std::move(batchKey));
+            count++;
+        }
+        if (inserted != NULL) {
+            inserted[order[i]] = success;
+        }
+    }
+    while (next < existing.size()) {
+        merged.push_back(std::move(existing[next]));
+        next++;
+    }
+
+    if (!merged.empty()) {
+        toBSTreeHelper(&merged[0], 0, static_cast<int>(merged.size()) - 1
+                , root);
+    }
+    return count;
+}
+
+
+
+/*-----------------------------retrieveBatch-----------------------------------
+ * Pre: Takes in an array of read-only NodeData pointers, targets, that are
+ *      not NULL. Takes in an int, size, which is the number of targets.
+ *      Takes in an array of NodeData pointers, results, with size entries.
+ *
+ * Post: Sets results[i] to the NodeData in the BinTree equal to targets[i],
+ *       or to NULL if there is none, and returns how many were found.
+ *
+ *       If the BinTree is small compared to the batch, the targets are
+ *       sorted and matched against one in-order walk of the BinTree.
+ *       Otherwise BATCH_LOOKUPS searches move down the BinTree side by side.
+ *       Each one takes turns between prefetching what it needs next (the
+ *       Node, then its NodeData) and using what it prefetched last time, so
+ *       the cache misses of different searches overlap instead of one
+ *       search waiting on each miss in turn. Leaves BinTree unchanged.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+int BasicBinTree<Key, Compare, Allocator>::retrieveBatch(
+        const value_type* const targets[], int size
+        , data_pointer results[]) const {
+    if (size <= 0) {
+        return 0;
+    }
+    int found = 0;
+
+    if (nodeSize(root) < size * BATCH_REBUILD_RATIO) {
+        vector<int> order(size);
+        for (int i = 0; i < size; i++) {
+            order[i] = i;
+        }
+        sort(order.begin(), order.end(), TargetLess(targets));
+        InorderWalk walk(root);
+        Node* nodePtr = walk.next();
+        for (int i = 0; i < size; i++) {
+            const value_type& target = *targets[order[i]];
+            while (nodePtr != NULL && keyLess(nodeValue(nodePtr), target)) {
+                nodePtr = walk.next();
+            }
+            if (nodePtr != NULL && !keyLess(target, nodeValue(nodePtr))) {
+                results[order[i]] = KeyTraits::address(nodePtr->data);
+                found++;
+            } else {
+                results[order[i]] = NULL;
+            }
+        }
+        return found;
+    }
+
+    Node* currentPtr[BATCH_LOOKUPS];
+    Node* candidatePtr[BATCH_LOOKUPS];      // as in findNode()
+    bool dataReady[BATCH_LOOKUPS];
+    for (int start = 0; start < size; start += BATCH_LOOKUPS) {
+        int group = min(BATCH_LOOKUPS, size - start);
+        for (int j = 0; j < group; j++) {
+            currentPtr[j] = root;
+            candidatePtr[j] = NULL;
+            dataReady[j] = false;
+            results[start + j] = NULL;
+        }
+        int active = group;
+        while (active > 0) {
+            for (int j = 0; j < group; j++) {
+                Node* nodePtr = currentPtr[j];
+                if (nodePtr == NULL) {
+                    continue;
+                }
+                if (!dataReady[j]) {
+                    prefetch(&nodeValue(nodePtr));
+                    dataReady[j] = true;
+                    continue;
+                }
+                const value_type& target = *targets[start + j];
+                if (keyLess(nodeValue(nodePtr), target)) {
+                    nodePtr = nodePtr->right;
+                } else {
+                    candidatePtr[j] = nodePtr;
+                    nodePtr = nodePtr->left;
+                }
+                if (nodePtr == NULL) {
+                    active--;
+                    Node* matchPtr = candidatePtr[j];
+                    if (matchPtr != NULL
+                            && !keyLess(target, nodeValue(matchPtr))) {
+                        results[start + j] = KeyTraits::address(
+                                matchPtr->data);
+                        found++;
+                    }
+                } else {
+                    prefetch(nodePtr);
+                }
+                currentPtr[j] = nodePtr;
+                dataReady[j] = false;
+            }
+        }
+    }
+    return found;
+}
+
+
+
+/*-----------------------------Equal Operator----------------------------------
+ * Pre: Takes in a read-only reference to another BinTree, otherTree.
+ *
+ * Post: Tests whether this BinTree is equal to otherTree, meaning that
+ *       are identical. (If they have the same Node structure with the same
+ *       values in them) Returns true if they identical. Returns false if they
+ *       are not.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::operator==(
+        const BasicBinTree& otherTree) const {
+    Node* otherPtr = otherTree.root;
+    Node* thisPtr = root;
+    atomic<bool> mismatch(false);
+    return checkEqual(otherPtr, thisPtr, mismatch);
+}
+
+
+
+/*----------------------------Unequal Operator---------------------------------
+ * Pre: Takes in a read-only reference to another BinTree, otherTree.
+ *
+ * Post: Tests whether this BinTree is unequal to otherTree, meaning that
+ *       they do not contain the same values and/or structure
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::operator!=(
+        const BasicBinTree& otherTree) const {
+    return !operator==(otherTree);
+}
+
+/*---------------------------Assignment Operator-------------------------------
+ * Pre: Takes in a read-only reference to another BinTree, otherTree.
+ *
+ * Post: Deletes everything in this BinTree, then makes it a deep copy of
+ *       otherTree with the same balancing mode. Assigning a BinTree to
+ *       itself is detected by address and does nothing. Returns this
+ *       BinTree.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+BasicBinTree<Key, Compare, Allocator>&
+        BasicBinTree<Key, Compare, Allocator>::operator=(
+        const BasicBinTree& otherTree) {
+    if (this != &otherTree) {
+        makeEmpty();
+        copyTree(otherTree.root, root, pool);
+        balanced = otherTree.balanced;
+    }
+    return *this;
+}
+
+
+
+/*------------------------Move Assignment Operator-----------------------------
+ * Pre: Takes in a reference to a BinTree, otherTree, that is about to go
+ *      away.
+ *
+ * Post: Deletes everything in this BinTree, then takes over otherTree's
+ *       Nodes, data, NodePool and balancing mode in O(1). otherTree is left
+ *       empty. Returns this BinTree.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+BasicBinTree<Key, Compare, Allocator>&
+        BasicBinTree<Key, Compare, Allocator>::operator=(
+        BasicBinTree&& otherTree) noexcept {
+    if (this != &otherTree) {
+        makeEmpty();
+        swap(otherTree);
+    }
+    return *this;
+}
+
+
+
+/*------------------------------------swap-------------------------------------
+ * Pre: Takes in a reference to another BinTree, otherTree.
+ *
+ * Post: Exchanges the root, NodePool and balancing mode of the two trees in
+ *       O(1). No Node or NodeData is copied or moved.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::swap(BasicBinTree& otherTree)
+        noexcept {
+    std::swap(root, otherTree.root);
+    std::swap(balanced, otherTree.balanced);
+    pool.swap(otherTree.pool);
+}
+
+
+
+/*-----------------------------------split-------------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, key. Takes in a
+ *      reference to another BinTree, greater. Takes in a pointer reference
+ *      to a NodeData, matchPtr.
+ *
+ * Post: Empties greater, then cuts this BinTree along the path to key with
+ *       splitNode(). The NodeData less than key stay here and the ones
+ *       greater than key go to greater. Since both halves start out in this
+ *       BinTree's pool, the larger half keeps the pool and only the smaller
+ *       half's Nodes are moved to a pool of their own. If greater is
+ *       balanced and this BinTree is not, greater's half is rebuilt with
+ *       rebuildSubtree() so that it is AVL balanced.
+ *       If a NodeData equal to key was found, matchPtr points to it, the
+ *       caller now owns it, and true is returned. Otherwise matchPtr is
+ *       NULL and false is returned. Does nothing and returns false if
+ *       greater is this BinTree.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::split(const value_type& key
+        , BasicBinTree& greater, Key& matchPtr) {
+    KeyTraits::clear(matchPtr);
+    if (&greater == this) {
+        return false;
+    }
+    greater.makeEmpty();
+    prepareForJoin(false);
+
+    Node* lessPtr;
+    Node* greaterPtr;
+    Node* matchNodePtr = splitNode(root, key, lessPtr, greaterPtr);
+    if (matchNodePtr != NULL) {
+        matchPtr = std::move(matchNodePtr->data);
+        freeNode(matchNodePtr, pool);
+    }
+    root = lessPtr;
+    greater.root = greaterPtr;
+    if (nodeSize(greaterPtr) > nodeSize(lessPtr)) {
+        pool.swap(greater.pool);
+        moveNodes(root, greater.pool, pool);
+    } else {
+        moveNodes(greater.root, pool, greater.pool);
+    }
+    if (root != NULL) {
+        root->parent = NULL;
+    }
+    if (greater.balanced && !balanced && greater.root != NULL) {
+        greater.rebuildSubtree(greater.root);
+    }
+    if (greater.root != NULL) {
+        greater.root->parent = NULL;
+    }
+    return matchNodePtr != NULL;
+}
+
+
+
+/*-----------------------------------join--------------------------------------
+ * Pre: Takes in a reference to another BinTree, otherTree.
+ *
+ * Post: If every NodeData in otherTree is greater than every one in this
+ *       BinTree, or every one is less, takes over otherTree's pool with
+ *       NodePool::splice() and joins the two roots with joinNodes(), using
+ *       the largest Node of the lower BinTree as the middle. If this
+ *       BinTree is balanced and otherTree is not, otherTree is rebuilt with
+ *       rebuildSubtree() first, so the result is still AVL balanced.
+ *       otherTree is left empty and true is returned. Otherwise, or if
+ *       otherTree is this BinTree, nothing changes and false is returned.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::join(BasicBinTree& otherTree) {
+    if (&otherTree == this) {
+        return false;
+    }
+    if (otherTree.root == NULL) {
+        return true;
+    }
+    if (root != NULL) {
+        const Node* thisFirst = root;
+        const Node* thisLast = root;
+        const Node* otherFirst = otherTree.root;
+        const Node* otherLast = otherTree.root;
+        while (thisFirst->left != NULL) {
+            thisFirst = thisFirst->left;
+        }
+        while (thisLast->right != NULL) {
+            thisLast = thisLast->right;
+        }
+        while (otherFirst->left != NULL) {
+            otherFirst = otherFirst->left;
+        }
+        while (otherLast->right != NULL) {
+            otherLast = otherLast->right;
+        }
+        bool otherAfter = keyLess(nodeValue(thisLast), nodeValue(otherFirst));
+        if (!otherAfter
+                && !keyLess(nodeValue(otherLast), nodeValue(thisFirst))) {
+            return false;
+        }
+        prepareForJoin(false);
+        otherTree.prepareForJoin(balanced);
+        Node* lowPtr = otherAfter ? root : otherTree.root;
+        Node* highPtr = otherAfter ? otherTree.root : root;
+        Node* middlePtr;
+        lowPtr = removeLast(lowPtr, middlePtr);
+        root = joinNodes(lowPtr, middlePtr, highPtr);
+        root->parent = NULL;
+    } else {
+        otherTree.prepareForJoin(balanced);
+        root = otherTree.root;
+    }
+    pool.splice(otherTree.pool);
+    otherTree.root = NULL;
+    return true;
+}
+
+
+
+/*---------------------------------unionWith-----------------------------------
+ * Pre: Takes in a reference to another BinTree, otherTree.
+ *
+ * Post: Makes this BinTree hold every NodeData that is in either BinTree
+ *       with unionNodes(). otherTree is left empty. Does nothing if
+ *       otherTree is this BinTree.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::unionWith(BasicBinTree& otherTree) {
+    if (&otherTree != this) {
+        setOperation(otherTree, &BasicBinTree::unionNodes);
+    }
+}
+
+
+
+/*---------------------------------intersect-----------------------------------
+ * Pre: Takes in a reference to another BinTree, otherTree.
+ *
+ * Post: Makes this BinTree hold only the NodeData that are in both BinTrees
+ *       with intersectNodes(). otherTree is left empty. Does nothing if
+ *       otherTree is this BinTree.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::intersect(BasicBinTree& otherTree) {
+    if (&otherTree != this) {
+        setOperation(otherTree, &BasicBinTree::intersectNodes);
+    }
+}
+
+
+
+/*---------------------------------difference----------------------------------
+ * Pre: Takes in a reference to another BinTree, otherTree.
+ *
+ * Post: Takes every NodeData that is also in otherTree out of this BinTree
+ *       with differenceNodes(). otherTree is left empty. If otherTree is
+ *       this BinTree, it is emptied.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::difference(
+        BasicBinTree& otherTree) {
+    if (&otherTree == this) {
+        makeEmpty();
+    } else {
+        setOperation(otherTree, &BasicBinTree::differenceNodes);
+    }
+}
+
+
+
+/*------------------------------Private: setOperation--------------------------
+ * Pre: Takes in a reference to another BinTree, otherTree, that is not this
+ *      one. Takes in one of unionNodes, intersectNodes or differenceNodes,
+ *      operation.
+ *
+ * Post: Makes sure both BinTrees are shallow enough with prepareForJoin(),
+ *       and that otherTree is AVL balanced if this BinTree is, then takes
+ *       over otherTree's pool with NodePool::splice() so that every
+ *       Node belongs to this BinTree, then runs operation on the two roots.
+ *       The Nodes operation let go of are given back to the pool afterwards,
+ *       on this thread, since the pool is not safe to share. otherTree is
+ *       left empty.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::setOperation(
+        BasicBinTree& otherTree, Node* (*operation)(Node*, Node*
+        , vector<Node*>&, int)) {
+    prepareForJoin(false);
+    otherTree.prepareForJoin(balanced);
+    Node* otherRoot = otherTree.root;
+    otherTree.root = NULL;
+    pool.splice(otherTree.pool);
+
+    vector<Node*> freed;
+    root = operation(root, otherRoot, freed, 0);
+    if (root != NULL) {
+        root->parent = NULL;
+    }
+    for (size_t i = 0; i < freed.size(); i++) {
+        freeNode(freed[i], pool);
+    }
+    prepareForJoin(false);
+}
+
+
+
+/*-----------------------------Private: prepareForJoin-------------------------
+ * Pre: Takes in a bool, needAVL, which is true if this BinTree's Nodes are
+ *      about to be joined into a balanced BinTree.
+ *
+ * Post: If this BinTree is not balanced and either needAVL is true or its
+ *       root is tooTall(), rebuilds it with rebuildSubtree(). Afterwards no
+ *       path is more than REBUILD_HEIGHT_FACTOR times the balanced height
+ *       long, and if needAVL is true the BinTree is AVL balanced, which
+ *       joinNodes() and rebalance() need of every subtree they are given.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::prepareForJoin(bool needAVL) {
+    if (!balanced && root != NULL && (needAVL || tooTall(root))) {
+        rebuildSubtree(root);
+    }
+}
+
+
+
+/*-------------------------------Private: joinNodes----------------------------
+ * Pre: Takes in pointers to the roots of two subtrees, left and right, either
+ *      of which may be NULL, and a Node, middle, that is in neither. Every
+ *      NodeData in left is less than middle's, which is less than every
+ *      NodeData in right.
+ *
+ * Post: If the heights of left and right differ by at most one, middle
+ *       becomes their parent. Otherwise goes down the inner side of the
+ *       taller subtree until it reaches a subtree close to the other's
+ *       height, joins there, and fixes and rebalances each Node on the way
+ *       back up. Returns the root of the joined subtree. Only recurses as
+ *       deep as the difference in heights.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::Node*
+        BasicBinTree<Key, Compare, Allocator>::joinNodes(Node* left
+        , Node* middle, Node* right) {
+    int leftHeight = nodeHeight(left);
+    int rightHeight = nodeHeight(right);
+    if (leftHeight > rightHeight + 1) {
+        left->right = joinNodes(left->right, middle, right);
+        updateNode(left);
+        rebalance(left);
+        return left;
+    }
+    if (rightHeight > leftHeight + 1) {
+        right->left = joinNodes(left, middle, right->left);
+        updateNode(right);
+        rebalance(right);
+        return right;
+    }
+    middle->left = left;
+    middle->right = right;
+    updateNode(middle);
+    return middle;
+}
+
+
+
+/*-------------------------------Private: joinPair-----------------------------
+ * Pre: Takes in pointers to the roots of two subtrees, left and right, either
+ *      of which may be NULL. Every NodeData in left is less than every one in
+ *      right.
+ *
+ * Post: Returns the root of one subtree holding both.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::Node*
+        BasicBinTree<Key, Compare, Allocator>::joinPair(Node* left
+        , Node* right) {
+    if (left == NULL) {
+        return right;
+    }
+    Node* middlePtr;
+    left = removeLast(left, middlePtr);
+    return joinNodes(left, middlePtr, right);
+}
+
+
+
+/*-------------------------------Private: removeLast---------------------------
+ * Pre: Takes in a pointer to a Node, currentPtr, that is not NULL. Takes in
+ *      a pointer reference to a Node, lastPtr.
+ *
+ * Post: Follows the right spine down to the largest Node, points lastPtr at
+ *       it, and returns the rest of the subtree, joined back together on the
+ *       way up.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::Node*
+        BasicBinTree<Key, Compare, Allocator>::removeLast(Node* currentPtr
+        , Node*& lastPtr) {
+    if (currentPtr->right == NULL) {
+        lastPtr = currentPtr;
+        return currentPtr->left;
+    }
+    Node* restPtr = removeLast(currentPtr->right, lastPtr);
+    return joinNodes(currentPtr->left, currentPtr, restPtr);
+}
+
+
+
+/*-------------------------------Private: splitNode----------------------------
+ * Pre: Takes in a pointer to a Node, currentPtr, or NULL. Takes in a
+ *      read-only reference to a NodeData, key. Takes in pointer references
+ *      to Nodes, lessPtr and greaterPtr.
+ *
+ * Post: Goes down the path to key. Each Node on it, with the side of it
+ *       that is off the path, is joined onto the less or the greater part
+ *       with joinNodes() on the way back up. lessPtr and greaterPtr point to
+ *       the two parts. Returns the Node equal to key, taken out of both
+ *       parts, or NULL if there is none.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::Node*
+        BasicBinTree<Key, Compare, Allocator>::splitNode(Node* currentPtr
+        , const value_type& key, Node*& lessPtr, Node*& greaterPtr) {
+    if (currentPtr == NULL) {
+        lessPtr = NULL;
+        greaterPtr = NULL;
+        return NULL;
+    }
+    Node* leftPtr = currentPtr->left;
+    Node* rightPtr = currentPtr->right;
+    Node* matchPtr;
+    if (keyLess(nodeValue(currentPtr), key)) {
+        Node* middlePtr;
+        matchPtr = splitNode(rightPtr, key, middlePtr, greaterPtr);
+        lessPtr = joinNodes(leftPtr, currentPtr, middlePtr);
+    } else if (keyLess(key, nodeValue(currentPtr))) {
+        Node* middlePtr;
+        matchPtr = splitNode(leftPtr, key, lessPtr, middlePtr);
+        greaterPtr = joinNodes(middlePtr, currentPtr, rightPtr);
+    } else {
+        lessPtr = leftPtr;
+        greaterPtr = rightPtr;
+        matchPtr = currentPtr;
+    }
+    return matchPtr;
+}
+
+
+
+/*-------------------------------Private: unionNodes---------------------------
+ * Pre: Takes in pointers to the roots of two subtrees, thisPtr and otherPtr,
+ *      from the same pool. Takes in a reference to a vector, freed. Takes in
+ *      an int, depth, which is how many times the work has been split
+ *      across threads.
+ *
+ * Post: Splits otherPtr's subtree at thisPtr's NodeData, unions the two less
+ *       halves and the two greater halves, and joins the results around
+ *       thisPtr. An equal Node from otherPtr's subtree has its NodeData
+ *       deleted and is pushed onto freed. Returns the root of the union.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::Node*
+        BasicBinTree<Key, Compare, Allocator>::unionNodes(Node* thisPtr
+        , Node* otherPtr, vector<Node*>& freed, int depth) {
+    if (thisPtr == NULL) {
+        return otherPtr;
+    }
+    if (otherPtr == NULL) {
+        return thisPtr;
+    }
+    bool fork = shouldFork(thisPtr, depth);
+    Node* otherLess;
+    Node* otherGreater;
+    Node* matchPtr = splitNode(otherPtr, nodeValue(thisPtr), otherLess
+            , otherGreater);
+    if (matchPtr != NULL) {
+        KeyTraits::dispose(matchPtr->data);
+        freed.push_back(matchPtr);
+    }
+    Node* lessPtr;
+    Node* greaterPtr;
+    bothHalves(&BasicBinTree::unionNodes, thisPtr->left, otherLess
+            , thisPtr->right, otherGreater, lessPtr, greaterPtr, freed, depth
+            , fork);
+    return joinNodes(lessPtr, thisPtr, greaterPtr);
+}
+
+
+
+/*-----------------------------Private: intersectNodes-------------------------
+ * Pre: Same as unionNodes().
+ *
+ * Post: Splits otherPtr's subtree at thisPtr's NodeData and intersects the
+ *       two less halves and the two greater halves. If an equal Node was
+ *       found, it is freed and the results are joined around thisPtr.
+ *       Otherwise thisPtr is freed and the results are joined without it.
+ *       A subtree facing an empty one is freed whole. Returns the root of
+ *       the intersection.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::Node*
+        BasicBinTree<Key, Compare, Allocator>::intersectNodes(Node* thisPtr
+        , Node* otherPtr, vector<Node*>& freed, int depth) {
+    if (thisPtr == NULL || otherPtr == NULL) {
+        discardNodes(thisPtr, freed);
+        discardNodes(otherPtr, freed);
+        return NULL;
+    }
+    bool fork = shouldFork(thisPtr, depth);
+    Node* otherLess;
+    Node* otherGreater;
+    Node* matchPtr = splitNode(otherPtr, nodeValue(thisPtr), otherLess
+            , otherGreater);
+    Node* lessPtr;
+    Node* greaterPtr;
+    bothHalves(&BasicBinTree::intersectNodes, thisPtr->left, otherLess
+            , thisPtr->right, otherGreater, lessPtr, greaterPtr, freed, depth
+            , fork);
+    if (matchPtr != NULL) {
+        KeyTraits::dispose(matchPtr->data);
+        freed.push_back(matchPtr);
+        return joinNodes(lessPtr, thisPtr, greaterPtr);
+    }
+    KeyTraits::dispose(thisPtr->data);
+    freed.push_back(thisPtr);
+    return joinPair(lessPtr, greaterPtr);
+}
+
+
+
+/*----------------------------Private: differenceNodes-------------------------
+ * Pre: Same as unionNodes().
+ *
+ * Post: Splits thisPtr's subtree at otherPtr's NodeData, freeing an equal
+ *       Node if there is one, and takes the two halves of otherPtr's
+ *       subtree away from the matching halves. otherPtr is freed and the
+ *       results are joined without it. Returns the root of what is left of
+ *       thisPtr's subtree.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::Node*
+        BasicBinTree<Key, Compare, Allocator>::differenceNodes(Node* thisPtr
+        , Node* otherPtr, vector<Node*>& freed, int depth) {
+    if (thisPtr == NULL || otherPtr == NULL) {
+        discardNodes(otherPtr, freed);
+        return thisPtr;
+    }
+    bool fork = shouldFork(thisPtr, depth);
+    Node* thisLess;
+    Node* thisGreater;
+    Node* matchPtr = splitNode(thisPtr, nodeValue(otherPtr), thisLess
+            , thisGreater);
+    if (matchPtr != NULL) {
+        KeyTraits::dispose(matchPtr->data);
+        freed.push_back(matchPtr);
+    }
+    Node* otherLess = otherPtr->left;
+    Node* otherGreater = otherPtr->right;
+    KeyTraits::dispose(otherPtr->data);
+    freed.push_back(otherPtr);
+    Node* lessPtr;
+    Node* greaterPtr;
+    bothHalves(&BasicBinTree::differenceNodes, thisLess, otherLess
+            , thisGreater, otherGreater, lessPtr, greaterPtr, freed, depth
+            , fork);
+    return joinPair(lessPtr, greaterPtr);
+}
+
+
+
+/*-------------------------------Private: bothHalves---------------------------
+ * Pre: Takes in one of the set operations, operation, the less and greater
+ *      halves of both subtrees, pointer references lessPtr and greaterPtr,
+ *      a reference to the vector freed, an int depth and a bool fork.
+ *
+ * Post: Sets lessPtr to operation on the less halves and greaterPtr to
+ *       operation on the greater halves. If fork is true the greater halves
+ *       are done by another thread with a freed vector of its own, which is
+ *       added to freed once it is done. The halves share no Nodes, so the
+ *       two never touch the same memory.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::bothHalves(Node* (*operation)(
+        Node*, Node*, vector<Node*>&, int), Node* thisLess, Node* otherLess
+        , Node* thisGreater, Node* otherGreater, Node*& lessPtr
+        , Node*& greaterPtr, vector<Node*>& freed, int depth, bool fork) {
+    if (fork) {
+        vector<Node*> greaterFreed;
+        future<Node*> greaterDone = async(launch::async, operation
+                , thisGreater, otherGreater, ref(greaterFreed), depth + 1);
+        lessPtr = operation(thisLess, otherLess, freed, depth + 1);
+        greaterPtr = greaterDone.get();
+        freed.insert(freed.end(), greaterFreed.begin(), greaterFreed.end());
+    } else {
+        lessPtr = operation(thisLess, otherLess, freed, depth + 1);
+        greaterPtr = operation(thisGreater, otherGreater, freed, depth + 1);
+    }
+}
+
+
+
+/*-----------------------------Private: discardNodes---------------------------
+ * Pre: Takes in a pointer to a Node, currentPtr, or NULL. Takes in a
+ *      reference to a vector, freed.
+ *
+ * Post: Deletes the NodeData of every Node under currentPtr and pushes each
+ *       Node onto freed, using an explicit stack.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::discardNodes(Node* currentPtr
+        , vector<Node*>& freed) {
+    vector<Node*> stack;
+    stack.push_back(currentPtr);
+    while (!stack.empty()) {
+        currentPtr = stack.back();
+        stack.pop_back();
+        if (currentPtr != NULL) {
+            stack.push_back(currentPtr->right);
+            stack.push_back(currentPtr->left);
+            KeyTraits::dispose(currentPtr->data);
+            freed.push_back(currentPtr);
+        }
+    }
+}
+
+
+
+/*------------------------------Private: moveNodes-----------------------------
+ * Pre: Takes in a reference pointer to a Node, currentPtr, whose subtree was
+ *      taken from fromPool. Takes in references to two NodePools, fromPool
+ *      and toPool.
+ *
+ * Post: Rebuilds the same subtree out of Nodes taken from toPool, moving each
+ *       NodeData across, and gives every old Node back to fromPool.
+ *       currentPtr points to the new subtree, whose root has a NULL parent.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::moveNodes(Node*& currentPtr
+        , Allocator& fromPool, Allocator& toPool) {
+    // Each entry is the Node to move, where to link the new one, and the
+    // new one's parent.
+    vector<pair<Node*, pair<Node**, Node*> > > stack;
+    stack.push_back(make_pair(currentPtr, make_pair(&currentPtr
+            , static_cast<Node*>(NULL))));
+    while (!stack.empty()) {
+        Node* fromPtr = stack.back().first;
+        Node** linkPtr = stack.back().second.first;
+        Node* parentPtr = stack.back().second.second;
+        stack.pop_back();
+        if (fromPtr != NULL) {
+            Node* movedPtr = newNode(std::move(fromPtr->data), toPool);
+            movedPtr->parent = parentPtr;
+            movedPtr->height = fromPtr->height;
+            movedPtr->size = fromPtr->size;
+            *linkPtr = movedPtr;
+            stack.push_back(make_pair(fromPtr->right
+                    , make_pair(&movedPtr->right, movedPtr)));
+            stack.push_back(make_pair(fromPtr->left
+                    , make_pair(&movedPtr->left, movedPtr)));
+            freeNode(fromPtr, fromPool);
+        }
+    }
+}
+
+
+
+/*-------------------------Private: checkEqual---------------------------------
+ * Pre: Takes in a read-only pointer to a Node in another BinTree, otherPtr.
+ *      Takes in a read-only pointer to a Node in this BinTree, thisPtr.
+ *      Takes in a reference to an atomic bool, mismatch, shared by every
+ *      thread working on the same comparison. Takes in an int, depth, which
+ *      is how many times the comparison has been split across threads.
+ *
+ * Post: Check the whole tree to see if they have the same structure AND they
+ *       contain the same values in each Node. Returns true if the two trees
+ *       are identical. Returns false if they are unequal. Nodes with
+ *       different heights cannot have the same structure, so they fail
+ *       without comparing any data. While shouldFork() allows it, the right
+ *       subtrees are compared by another thread. The first difference found
+ *       sets mismatch, and every thread stops as soon as it sees it.
+ *-----------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::checkEqual(const Node* otherPtr
+        , const Node* thisPtr, atomic<bool>& mismatch, int depth) const {
+    if (shouldFork(thisPtr, depth) && otherPtr != NULL
+            && otherPtr->height == thisPtr->height
+            && nodeValue(otherPtr) == nodeValue(thisPtr)) {
+        future<bool> rightEqual = async(launch::async
+                , &BasicBinTree::checkEqual, this, otherPtr->right
+                , thisPtr->right, ref(mismatch), depth + 1);
+        bool leftEqual = checkEqual(otherPtr->left, thisPtr->left, mismatch
+                , depth + 1);
+        if (!leftEqual) {
+            mismatch.store(true, memory_order_relaxed);
+        }
+        return rightEqual.get() && leftEqual;
+    }
+
+    vector<pair<const Node*, const Node*> > stack;
+    stack.push_back(make_pair(otherPtr, thisPtr));
+    while (!stack.empty()) {
+        otherPtr = stack.back().first;
+        thisPtr = stack.back().second;
+        stack.pop_back();
+        if (otherPtr == NULL || thisPtr == NULL) {
+            if (otherPtr != thisPtr) {
+                mismatch.store(true, memory_order_relaxed);
+                return false;
+            }
+        } else if (otherPtr->height != thisPtr->height
+                || !(nodeValue(otherPtr) == nodeValue(thisPtr))
+                || mismatch.load(memory_order_relaxed)) {
+            mismatch.store(true, memory_order_relaxed);
+            return false;
+        } else {
+            stack.push_back(make_pair(otherPtr->right, thisPtr->right));
+            stack.push_back(make_pair(otherPtr->left, thisPtr->left));
+        }
+    }
+    return true;
+}
+
+
+
+/*----------------------------------insert-------------------------------------
+ * Pre: Takes in a pointer to a NodeData, insertPtr, which is the value that
+ *      will be inserted into the BinTree.
+ *
+ * Post: Inserts insertPtr into the BinTree. Can only insert if the BinTree
+ *      does not contain insertPtr's value. Returns true if it was successfully
+ *      inserted. Returns false if it cannot be inserted.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::insert(Key insertPtr) {
+    STATS_PROBE(insertCounters);
+    bool insert = insertHelper(insertPtr, root);
+    return insert;
+}
+
+
+
+/*-----------------------------Private: insertHelper---------------------------
+ * Pre: Takes in a reference to a Key, insertPtr. Takes in a pointer to a
+ *      reference Node, currentPtr, which is a node that is currently in the
+ *      tree.
+ *
+ * Post: Creates a new Node and moves insertPtr into it, then adds it
+ *       into the tree. The lesser-value Nodes are inserted to the left,
+ *       while greater-value Nodes are inserted to the right. Like findNode,
+ *       it compares once per level and checks for an equal value only at
+ *       the bottom. The path taken is kept in insertPath so heights can be
+ *       fixed (and the BinTree rebalanced, if balanced) on the way back up
+ *       without recursion.
+ *       Returns true if successfully inserted into tree. Returns false if
+ *       no insertion was made, leaving insertPtr as it was.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::insertHelper(Key& insertPtr
+        , Node*& currentPtr) {
+    const value_type& insertValue = KeyTraits::value(insertPtr);
+    Node** linkPtr = &currentPtr;
+    insertPath.clear();
+    Node* candidatePtr = NULL;          // same single compare as findNode()
+    uint64_t insertPrefix = prefixOf(insertValue);
+    while (*linkPtr != NULL) {
+        prefetch((*linkPtr)->left);         // same overlap as findNode()
+        prefetch((*linkPtr)->right);
+        insertPath.push_back(linkPtr);
+        STATS_VISIT(static_cast<int>(insertPath.size()));
+        STATS_COMPARE();
+        int order = searchOrder(*linkPtr, insertValue, insertPrefix);
+        if (order < 0) {
+            linkPtr = &(*linkPtr)->right;
+        } else if (order == 0) {
+            return false;
+        } else {
+            candidatePtr = *linkPtr;
+            linkPtr = &(*linkPtr)->left;
+        }
+    }
+    if (!USE_PREFIX && candidatePtr != NULL) {
+        STATS_COMPARE();
+        if (!keyLess(insertValue, nodeValue(candidatePtr))) {
+            return false;
+        }
+    }
+    *linkPtr = newNode(std::move(insertPtr));
+
+    // Walk back up the path. Once a subtree keeps its old height, nothing
+    // above it can change shape, and the rest only need one more Node
+    // counted.
+    bool heightChanged = true;
+    while (!insertPath.empty()) {
+        Node*& ancestorPtr = *insertPath.back();
+        insertPath.pop_back();
+        if (heightChanged) {
+            int oldHeight = ancestorPtr->height;
+            updateNode(ancestorPtr);
+            if (balanced) {
+                rebalance(ancestorPtr);
+            }
+            heightChanged = ancestorPtr->height != oldHeight;
+        } else {
+            ancestorPtr->size++;
+        }
+    }
+    return true;
+}
+
+
+
+/*---------------------------------remove--------------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target. Takes in a
+ *      pointer reference to a NodeData, removedPtr.
+ *
+ * Post: Finds the Node equal to target with the same single-comparison
+ *       descent as findNode, keeping the path in insertPath. If the Node has
+ *       two children, the next larger NodeData is moved up into it and that
+ *       Node, which has no left child, is taken out instead. The Node taken
+ *       out is replaced by its only child and given back to the pool.
+ *
+ *       The path is then fixed from the bottom up. If the BinTree is
+ *       balanced, each Node on it is rebalanced. Otherwise the highest Node
+ *       on it that is tooTall() has its whole subtree rebuilt by
+ *       rebuildSubtree(). A rebuilt subtree is as short as it can be, so it
+ *       takes many more changes below it before it is too tall again and
+ *       the cost of each rebuild is spread over them.
+ *
+ *       Points removedPtr at target's NodeData, which the caller now owns,
+ *       and returns true. If target is not in the BinTree, sets removedPtr
+ *       to NULL and returns false.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::remove(const value_type& target
+        , Key& removedPtr) {
+    STATS_PROBE(removeCounters);
+    Node** linkPtr = &root;
+    size_t candidateDepth = 0;
+    Node* candidatePtr = NULL;
+    bool found = false;
+    uint64_t targetPrefix = prefixOf(target);
+    insertPath.clear();
+    while (*linkPtr != NULL && !found) {
+        insertPath.push_back(linkPtr);
+        STATS_VISIT(static_cast<int>(insertPath.size()));
+        STATS_COMPARE();
+        int order = searchOrder(*linkPtr, target, targetPrefix);
+        if (order < 0) {
+            linkPtr = &(*linkPtr)->right;
+        } else {
+            found = order == 0;
+            candidatePtr = *linkPtr;
+            candidateDepth = insertPath.size();
+            linkPtr = &(*linkPtr)->left;
+        }
+    }
+    if (!USE_PREFIX && candidatePtr != NULL) {
+        STATS_COMPARE();
+        found = !keyLess(target, nodeValue(candidatePtr));
+    }
+    if (!found) {
+        KeyTraits::clear(removedPtr);
+        return false;
+    }
+    insertPath.resize(candidateDepth);      // path ends at the link to target
+
+    Node* targetPtr = candidatePtr;
+    removedPtr = std::move(targetPtr->data);
+    if (targetPtr->left != NULL && targetPtr->right != NULL) {
+        Node** nextLinkPtr = &targetPtr->right;
+        insertPath.push_back(nextLinkPtr);
+        while ((*nextLinkPtr)->left != NULL) {
+            nextLinkPtr = &(*nextLinkPtr)->left;
+            insertPath.push_back(nextLinkPtr);
+        }
+        targetPtr->data = std::move((*nextLinkPtr)->data);
+        targetPtr->setPrefix((*nextLinkPtr)->getPrefix());
+    }
+
+    Node** unlinkPtr = insertPath.back();
+    insertPath.pop_back();
+    Node* oldPtr = *unlinkPtr;
+    Node* childPtr = oldPtr->left != NULL ? oldPtr->left : oldPtr->right;
+    if (childPtr != NULL) {
+        childPtr->parent = oldPtr->parent;
+    }
+    *unlinkPtr = childPtr;
+    freeNode(oldPtr, pool);
+
+    size_t rebuildDepth = insertPath.size();        // nothing to rebuild yet
+    for (size_t i = insertPath.size(); i > 0; i--) {
+        Node*& ancestorPtr = *insertPath[i - 1];
+        updateNode(ancestorPtr);
+        if (balanced) {
+            rebalance(ancestorPtr);
+        } else if (tooTall(ancestorPtr)) {
+            rebuildDepth = i - 1;
+        }
+    }
+    if (rebuildDepth < insertPath.size()) {
+        rebuildSubtree(*insertPath[rebuildDepth]);
+        for (size_t i = rebuildDepth; i > 0; i--) {
+            updateNode(*insertPath[i - 1]);
+        }
+    }
+    return true;
+}
+
+
+
+/*----------------------------Private: tooTall---------------------------------
+ * Pre: Takes in a read-only pointer to a Node, currentPtr, that is not NULL.
+ *
+ * Post: Returns true if the height of currentPtr's subtree is more than
+ *       REBUILD_HEIGHT_FACTOR times the height a balanced subtree with the
+ *       same number of Nodes would have. Returns false otherwise.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::tooTall(const Node* currentPtr) {
+    int balancedHeight = 0;
+    for (int size = currentPtr->size; size > 0; size /= 2) {
+        balancedHeight++;
+    }
+    return currentPtr->height > REBUILD_HEIGHT_FACTOR * balancedHeight;
+}
+
+
+
+/*-------------------------Private: rebuildSubtree-----------------------------
+ * Pre: Takes in a reference pointer to a Node, currentPtr, that is not NULL.
+ *
+ * Post: Moves every NodeData under currentPtr out in order with InorderWalk,
+ *       giving each Node back to the pool as soon as the walk is past it,
+ *       then builds them back into a balanced subtree with toBSTreeHelper().
+ *       The new Nodes reuse the slots just freed. currentPtr points to the
+ *       new subtree, which keeps the old one's parent.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::rebuildSubtree(Node*& currentPtr) {
+    Node* parentPtr = currentPtr->parent;
+    vector<Key> sorted;
+    sorted.reserve(currentPtr->size);
+    InorderWalk walk(currentPtr);
+    for (Node* nodePtr = walk.next(); nodePtr != NULL; nodePtr = walk.next()) {
+        sorted.push_back(std::move(nodePtr->data));
+        freeNode(nodePtr, pool);
+    }
+    toBSTreeHelper(&sorted[0], 0, static_cast<int>(sorted.size()) - 1
+            , currentPtr);
+    currentPtr->parent = parentPtr;
+}
+
+
+
+/*---------------------------Private: nodeHeight-------------------------------
+ * Pre: Takes in a read-only pointer to a Node, currentPtr, or NULL.
+ *
+ * Post: Returns the cached height of the subtree rooted at currentPtr. An
+ *       empty subtree has a height of 0.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+int BasicBinTree<Key, Compare, Allocator>::nodeHeight(const Node* currentPtr) {
+    if (currentPtr == NULL) {
+        return 0;
+    }
+    return currentPtr->height;
+}
+
+
+
+/*---------------------------Private: nodeSize---------------------------------
+ * Pre: Takes in a read-only pointer to a Node, currentPtr, or NULL.
+ *
+ * Post: Returns the cached number of Nodes in the subtree rooted at
+ *       currentPtr. An empty subtree has a size of 0.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+int BasicBinTree<Key, Compare, Allocator>::nodeSize(const Node* currentPtr) {
+    if (currentPtr == NULL) {
+        return 0;
+    }
+    return currentPtr->size;
+}
+
+
+
+/*---------------------------Private: updateNode-------------------------------
+ * Pre: Takes in a pointer to a Node, currentPtr, that is not NULL. Assumes
+ *      both children already have correct heights and sizes.
+ *
+ * Post: Sets currentPtr's height to one more than its taller child, and its
+ *       size to one more than the sizes of its children added together.
+ *       Each child's parent is set to currentPtr.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::updateNode(Node* currentPtr) {
+    int left = nodeHeight(currentPtr->left);
+    int right = nodeHeight(currentPtr->right);
+    if (currentPtr->left != NULL) {
+        currentPtr->left->parent = currentPtr;
+    }
+    if (currentPtr->right != NULL) {
+        currentPtr->right->parent = currentPtr;
+    }
+    if (left > right) {
+        currentPtr->height = left + 1;
+    } else {
+        currentPtr->height = right + 1;
+    }
+    currentPtr->size = nodeSize(currentPtr->left)
+            + nodeSize(currentPtr->right) + 1;
+}
+
+
+
+/*---------------------------Private: rotateLeft-------------------------------
+ * Pre: Takes in a reference pointer to a Node, currentPtr, that has a right
+ *      child.
+ *
+ * Post: The right child becomes the root of this subtree and currentPtr
+ *       becomes its left child. currentPtr now points to the new root, which
+ *       takes over the old root's parent.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::rotateLeft(Node*& currentPtr) {
+    Node* pivotPtr = currentPtr->right;
+    pivotPtr->parent = currentPtr->parent;
+    currentPtr->right = pivotPtr->left;
+    pivotPtr->left = currentPtr;
+    updateNode(currentPtr);
+    updateNode(pivotPtr);
+    currentPtr = pivotPtr;
+}
+
+
+
+/*---------------------------Private: rotateRight------------------------------
+ * Pre: Takes in a reference pointer to a Node, currentPtr, that has a left
+ *      child.
+ *
+ * Post: The left child becomes the root of this subtree and currentPtr
+ *       becomes its right child. currentPtr now points to the new root, which
+ *       takes over the old root's parent.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::rotateRight(Node*& currentPtr) {
+    Node* pivotPtr = currentPtr->left;
+    pivotPtr->parent = currentPtr->parent;
+    currentPtr->left = pivotPtr->right;
+    pivotPtr->right = currentPtr;
+    updateNode(currentPtr);
+    updateNode(pivotPtr);
+    currentPtr = pivotPtr;
+}
+
+
+
+/*---------------------------Private: rebalance--------------------------------
+ * Pre: Takes in a reference pointer to a Node, currentPtr, that is not NULL
+ *      and whose children are AVL balanced with correct heights.
+ *
+ * Post: If the two subtrees of currentPtr differ in height by more than one,
+ *       does the single or double rotation that fixes it. A taller child
+ *       whose own subtrees are even, which only happens after a remove,
+ *       gets a single rotation. currentPtr points to the root of the
+ *       balanced subtree afterwards.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::rebalance(Node*& currentPtr) {
+    int balance = nodeHeight(currentPtr->left) - nodeHeight(currentPtr->right);
+    if (balance > 1) {
+        if (nodeHeight(currentPtr->left->left)
+                < nodeHeight(currentPtr->left->right)) {
+            rotateLeft(currentPtr->left);
+        }
+        rotateRight(currentPtr);
+    } else if (balance < -1) {
+        if (nodeHeight(currentPtr->right->right)
+                < nodeHeight(currentPtr->right->left)) {
+            rotateRight(currentPtr->right);
+        }
+        rotateLeft(currentPtr);
+    }
+}
+
+
+
+/*-------------------------------shapeReport-----------------------------------
+ * Pre: None.
+ *
+ * Post: Walks every Node once with an explicit stack and returns a
+ *       ShapeReport of the BinTree: its size and height, the height it
+ *       would have if balanced, the average depth of its Nodes and how
+ *       many Nodes have each balance factor. Leaves BinTree unchanged.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+ShapeReport BasicBinTree<Key, Compare, Allocator>::shapeReport() const {
+    ShapeReport report;
+    report.size = nodeSize(root);
+    report.height = nodeHeight(root);
+    report.balancedHeight = 0;
+    for (int size = report.size; size > 0; size /= 2) {
+        report.balancedHeight++;
+    }
+    for (int i = 0; i < 5; i++) {
+        report.balanceCounts[i] = 0;
+    }
+
+    double depthTotal = 0;
+    vector<pair<const Node*, int> > stack;
+    stack.push_back(make_pair(root, 1));
+    while (!stack.empty()) {
+        const Node* nodePtr = stack.back().first;
+        int depth = stack.back().second;
+        stack.pop_back();
+        if (nodePtr != NULL) {
+            depthTotal += depth;
+            int balance = nodeHeight(nodePtr->left) - nodeHeight(nodePtr->right);
+            balance = max(-2, min(2, balance));
+            report.balanceCounts[balance + 2]++;
+            stack.push_back(make_pair(nodePtr->left, depth + 1));
+            stack.push_back(make_pair(nodePtr->right, depth + 1));
+        }
+    }
+    report.averageDepth = report.size > 0 ? depthTotal / report.size : 0;
+    return report;
+}
+
+
+
+#ifdef BINTREE_STATS
+/*----------------------------------stats--------------------------------------
+ * Pre: None.
+ *
+ * Post: Returns a snapshot of the counters for every instrumented
+ *       operation since this BinTree was created or resetStats() was called.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+BinTreeStats BasicBinTree<Key, Compare, Allocator>::stats() const {
+    BinTreeStats snapshot;
+    snapshot.insert = insertCounters.snapshot();
+    snapshot.retrieve = retrieveCounters.snapshot();
+    snapshot.getHeight = heightCounters.snapshot();
+    snapshot.remove = removeCounters.snapshot();
+    return snapshot;
+}
+
+
+
+/*--------------------------------resetStats-----------------------------------
+ * Pre: None.
+ *
+ * Post: Sets every operation counter back to 0.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::resetStats() {
+    insertCounters.reset();
+    retrieveCounters.reset();
+    heightCounters.reset();
+    removeCounters.reset();
+}
+#endif
+
+
+
+/*---------------------------------isEmpty-------------------------------------
+ * Pre: None.
+ *
+ * Post: Checks if the BinTree is empty. Returns true if the BinTree is empty.
+ *       returns false if it is not empty.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::isEmpty() const {
+    return root == NULL;
+}
+
+
+
+/*-----------------------------------size--------------------------------------
+ * Pre: None.
+ *
+ * Post: Returns the number of NodeData in the BinTree, read from the size
+ *       cached in the root.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+int BasicBinTree<Key, Compare, Allocator>::size() const {
+    return nodeSize(root);
+}
+
+
+
+/*-----------------------------------rank--------------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target, which does not
+ *      have to be in the BinTree.
+ *
+ * Post: Returns how many NodeData in the BinTree are less than target.
+ *       Calls private method countBelow(). Leaves BinTree unchanged.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+int BasicBinTree<Key, Compare, Allocator>::rank(const value_type& target)
+        const {
+    return countBelow(target, false);
+}
+
+
+
+/*----------------------------------select-------------------------------------
+ * Pre: Takes in an int, k. Takes in a pointer reference to a NodeData,
+ *      nodeDataPtr.
+ *
+ * Post: Descends from the root using the cached subtree sizes to skip every
+ *       subtree that cannot hold rank k, so it runs in O(height). Points
+ *       nodeDataPtr at the NodeData with exactly k smaller NodeData in the
+ *       BinTree and returns true. If k is negative or not less than size(),
+ *       sets nodeDataPtr to NULL and returns false.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::select(int k
+        , data_pointer& nodeDataPtr) const {
+    nodeDataPtr = NULL;
+    if (k < 0 || k >= nodeSize(root)) {
+        return false;
+    }
+    Node* currentPtr = root;
+    while (true) {
+        int leftSize = nodeSize(currentPtr->left);
+        if (k < leftSize) {
+            currentPtr = currentPtr->left;
+        } else if (k == leftSize) {
+            nodeDataPtr = KeyTraits::address(currentPtr->data);
+            return true;
+        } else {
+            k -= leftSize + 1;
+            currentPtr = currentPtr->right;
+        }
+    }
+}
+
+
+
+/*--------------------------------countRange-----------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, low. Takes in a
+ *      read-only reference to a NodeData, high. Neither has to be in the
+ *      BinTree.
+ *
+ * Post: Returns how many NodeData are greater than or equal to low and less
+ *       than or equal to high, as the difference of two countBelow() calls.
+ *       Returns 0 if high is less than low. Leaves BinTree unchanged.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+int BasicBinTree<Key, Compare, Allocator>::countRange(const value_type& low
+        , const value_type& high) const {
+    if (keyLess(high, low)) {
+        return 0;
+    }
+    return countBelow(high, true) - countBelow(low, false);
+}
+
+
+
+/*---------------------------Private: countBelow-------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target. Takes in a
+ *      bool, inclusive, which is true if NodeData equal to target should be
+ *      counted as well.
+ *
+ * Post: Descends one path from the root, adding up the cached size of every
+ *       left subtree (plus the Node itself) that it passes on the way to the
+ *       right. Each level is one compareNode(), which is a prefix compare
+ *       when Nodes keep one. Returns the number of NodeData less than
+ *       target, or less than or equal to it if inclusive is true.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+int BasicBinTree<Key, Compare, Allocator>::countBelow(const value_type& target
+        , bool inclusive) const {
+    int count = 0;
+    uint64_t targetPrefix = prefixOf(target);
+    const Node* currentPtr = root;
+    while (currentPtr != NULL) {
+        int order = compareNode(currentPtr, target, targetPrefix);
+        if (order > 0) {
+            currentPtr = currentPtr->left;
+        } else if (order < 0) {
+            count += nodeSize(currentPtr->left) + 1;
+            currentPtr = currentPtr->right;
+        } else {
+            count += nodeSize(currentPtr->left);
+            if (inclusive) {
+                count++;
+            }
+            return count;
+        }
+    }
+    return count;
+}
+
+
+
+/*---------------------------------isBalanced----------------------------------
+ * Pre: None.
+ *
+ * Post: Returns true if this BinTree keeps itself AVL balanced on insert.
+ *       Returns false if it does plain BST insertion.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::isBalanced() const {
+    return balanced;
+}
+
+
+
+/* ----------------------------bstreeToArray-----------------------------------
+ * Pre: Takes in an array that contains the NodeData pointer data type, array.
+ *
+ * Post: Moves all of the data stored in this BinTree into the array. The
+ *       BinTree becomes empty.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::bstreeToArray(Key array[]) {
+    int startIndex = 0;
+    toArrayHelper(array, root, startIndex);
+    pool.releaseAll();      // every NodeData was moved out, just free Nodes
+    root = NULL;
+}
+
+
+
+/*---------------------------Private: toArrayHelper----------------------------
+ * Pre: Takes in an array that is of NodeData pointer type. Takes in a pointer
+ *      to a Node, currentPtr, which points to a Node in this BinTree. Takes
+ *      in a reference to an int, index, which is the current index in the array.
+ *
+ * Post: Moves all of the data in the BinTree to the tree by using an in-order
+ *      traversal. The BinTree's structure remains but no data is in it.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::toArrayHelper(Key arrayPtr[]
+        , Node* currentPtr, int& index) {
+    InorderWalk walk(currentPtr);
+    for (Node* nodePtr = walk.next(); nodePtr != NULL; nodePtr = walk.next()) {
+        arrayPtr[index] = std::move(nodePtr->data);
+        nodePtr->~Node();
+        index++;
+    }
+}
+
+
+/*--------------------------------copyToArray----------------------------------
+ * Pre: Takes in an array of NodeData pointers, array, with room for at
+ *      least capacity entries. Takes in an int, capacity.
+ *
+ * Post: Writes a new copy of each of the first capacity NodeData, in order,
+ *       into array with exportHelper(). Returns how many were written, which
+ *       is the smaller of size() and capacity. BinTree remains unchanged.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+int BasicBinTree<Key, Compare, Allocator>::copyToArray(Key array[]
+        , int capacity) const {
+    int count = min(nodeSize(root), max(capacity, 0));
+    exportHelper(root, 0, count, NULL, array, 0);
+    return count;
+}
+
+
+
+/*-------------------------------copyToVector----------------------------------
+ * Pre: Takes in a reference to a vector of NodeData pointers, copies.
+ *
+ * Post: Resizes copies to size() and fills it, in order, with a new copy of
+ *       every NodeData. Whatever copies held before is overwritten, not
+ *       deleted. BinTree remains unchanged.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::copyToVector(vector<Key>& copies)
+        const {
+    copies.resize(nodeSize(root));
+    if (!copies.empty()) {
+        exportHelper(root, 0, static_cast<int>(copies.size()), NULL
+                , &copies[0], 0);
+    }
+}
+
+
+
+/*-----------------------------------view--------------------------------------
+ * Pre: Takes in an array of read-only NodeData pointers, array, with room for
+ *      at least capacity entries. Takes in an int, capacity.
+ *
+ * Post: Points the first entries of array, in order, at the first capacity
+ *       NodeData in the BinTree. Nothing is copied and the BinTree still
+ *       owns the NodeData. Returns how many entries were written.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+int BasicBinTree<Key, Compare, Allocator>::view(const value_type* array[]
+        , int capacity) const {
+    int count = min(nodeSize(root), max(capacity, 0));
+    exportHelper(root, 0, count, array, NULL, 0);
+    return count;
+}
+
+
+
+/*-----------------------------------view--------------------------------------
+ * Pre: Takes in a reference to a vector of read-only NodeData pointers,
+ *      pointers.
+ *
+ * Post: Resizes pointers to size() and points each entry, in order, at a
+ *       NodeData in the BinTree. Nothing is copied and the BinTree still
+ *       owns the NodeData.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::view(
+        vector<const value_type*>& pointers) const {
+    pointers.resize(nodeSize(root));
+    if (!pointers.empty()) {
+        exportHelper(root, 0, static_cast<int>(pointers.size()), &pointers[0]
+                , NULL, 0);
+    }
+}
+
+
+
+/*---------------------------Private: exportHelper-----------------------------
+ * Pre: Takes in a read-only pointer to a Node, currentPtr, or NULL. Takes in
+ *      two ints, offset, which is where currentPtr's smallest NodeData goes,
+ *      and capacity. Takes in two arrays, view and copies, exactly one of
+ *      which is not NULL. Takes in an int, depth, which is how many times
+ *      the work has been split across threads.
+ *
+ * Post: Writes every NodeData under currentPtr whose index is below
+ *       capacity into copies, as a new copy, or into view, as a pointer.
+ *       Each subtree's cached size says exactly where its NodeData go, so
+ *       while shouldFork() allows it the right subtree is written by
+ *       another thread at the same time as the left. Smaller subtrees are
+ *       walked with InorderWalk, which stops once capacity is reached.
+ *       BinTree remains unchanged.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::exportHelper(const Node* currentPtr
+        , int offset, int capacity, const value_type* view[], Key copies[]
+        , int depth) const {
+    if (currentPtr == NULL || offset >= capacity) {
+        return;
+    }
+    if (shouldFork(currentPtr, depth)) {
+        int middle = offset + nodeSize(currentPtr->left);
+        future<void> rightDone = async(launch::async
+                , &BasicBinTree::exportHelper, this, currentPtr->right
+                , middle + 1, capacity, view, copies, depth + 1);
+        exportHelper(currentPtr->left, offset, capacity, view, copies
+                , depth + 1);
+        if (middle < capacity) {
+            if (copies != NULL) {
+                copies[middle] = KeyTraits::copy(currentPtr->data);
+            } else {
+                view[middle] = &nodeValue(currentPtr);
+            }
+        }
+        rightDone.get();
+        return;
+    }
+
+    InorderWalk walk(const_cast<Node*>(currentPtr));
+    for (Node* nodePtr = walk.next(); nodePtr != NULL && offset < capacity
+            ; nodePtr = walk.next()) {
+        if (copies != NULL) {
+            copies[offset] = KeyTraits::copy(nodePtr->data);
+        } else {
+            view[offset] = &nodeValue(nodePtr);
+        }
+        offset++;
+    }
+}
+
+
+
+/*------------------------------arrayToBSTree----------------------------------
+ * Pre: Takes in an array of NodeData pointer data, array, that is filled with
+ *      the data that will go into the BinTree and ends with a NULL.
+ *
+ * Post: Moves all of the data from array into this BinTree. The data is
+ *       entered so the BinTree is balanced on both sides. Anything that was
+ *       in the BinTree before is deleted.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::arrayToBSTree(Key array[]) {
+    int size = 0;
+    while (array[size] != NULL) {
+        size++;
+    }
+    arrayToBSTree(array, size);
+}
+
+
+
+/*------------------------------arrayToBSTree----------------------------------
+ * Pre: Takes in an array of NodeData pointer data, array, whose first size
+ *      entries are the data that will go into the BinTree in sorted order.
+ *      Takes in an int, size. Takes in a bool, checkSorted, which is true if
+ *      the order of the array should be checked first.
+ *
+ * Post: Deletes anything that was in the BinTree, then moves array[0] to
+ *       array[size - 1] into this BinTree in one O(size) pass so the BinTree
+ *       is balanced on both sides. Those entries of array are set to NULL.
+ *       Returns true. If checkSorted is true and the entries are not
+ *       strictly increasing, returns false and leaves both the array and
+ *       the (empty) BinTree unchanged.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::arrayToBSTree(Key array[], int size
+        , bool checkSorted) {
+    this->makeEmpty();
+    if (checkSorted) {
+        for (int i = 1; i < size; i++) {
+            if (!keyLess(KeyTraits::value(array[i - 1])
+                    , KeyTraits::value(array[i]))) {
+                return false;
+            }
+        }
+    }
+    toBSTreeHelper(array, 0, size - 1, root);
+    return true;
+}
+
+/*-----------------------------Private: toBSTreeHelper-------------------------
+ * Pre: Takes in an array of pointers to NodeData that contains all of the data
+ *      that will be entered into this BinTree. Takes in an int, min, that is
+ *      the minimum index, and another int, max, that is the maximum index.
+ *      Takes in a pointer reference to a Node, currentPtr, which is the Node
+ *      currently being pointed to in this BinTree. **Assumes that currentPtr
+ *      is an empty subtree. **IF IT IS NOT EMPTY THEN MEMORY LEAK.
+ *
+ * Post: Moves array[min] to array[max] into the subtree at currentPtr. The
+ *      middle entry becomes the root and each half is built the same way, so
+ *      every entry is visited once and the subtree is balanced. Only
+ *      recurses O(log n) deep.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::toBSTreeHelper(Key array[], int min
+        , int max, Node*& currentPtr) {
+    if (min > max) {
+        currentPtr = NULL;
+        return;
+    }
+    int middle = min + (max - min) / 2;
+    currentPtr = newNode(std::move(array[middle]));
+    KeyTraits::clear(array[middle]);
+    toBSTreeHelper(array, min, middle - 1, currentPtr->left);
+    toBSTreeHelper(array, middle + 1, max, currentPtr->right);
+    updateNode(currentPtr);
+}
+
+
+
+/*---------------------------------freeze--------------------------------------
+ * Pre: None.
+ *
+ * Post: Collects the NodeData in order with InorderWalk, then copies them
+ *       into a new FrozenTree, which is returned. The BinTree is unchanged
+ *       and later changes to it are not seen by the FrozenTree.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+FrozenTree BasicBinTree<Key, Compare, Allocator>::freeze() const {
+    vector<const value_type*> sorted;
+    InorderWalk walk(root);
+    for (Node* nodePtr = walk.next(); nodePtr != NULL; nodePtr = walk.next()) {
+        sorted.push_back(&nodeValue(nodePtr));
+    }
+    if (sorted.empty()) {
+        return FrozenTree();
+    }
+    return FrozenTree(&sorted[0], static_cast<int>(sorted.size()));
+}
+
+
+
+/*-------------------------------writeBinary-----------------------------------
+ * Pre: Takes in a reference to an ostream, outStream, opened in binary mode.
+ *
+ * Post: Streams the BinTree to outStream in the file format described in
+ *       mappedtree.h: a header with the number of NodeData, one record per
+ *       NodeData in order holding the text its output operator writes, the
+ *       offset of every record, and the offset of that table. Nothing but
+ *       the record offsets is held in memory. Returns true if outStream is
+ *       still good afterwards. BinTree remains unchanged.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::writeBinary(ostream& outStream)
+        const {
+    int count = nodeSize(root);
+    char header[MappedTree::HEADER_SIZE];
+    memcpy(header, MappedTree::MAGIC, sizeof(MappedTree::MAGIC));
+    MappedTree::putUint32(header + 4, MappedTree::VERSION);
+    MappedTree::putUint64(header + 8, count);
+    outStream.write(header, sizeof(header));
+
+    vector<uint64_t> offsets;
+    offsets.reserve(count);
+    uint64_t position = MappedTree::HEADER_SIZE;
+    ostringstream keyStream;
+    char bytes[8];
+    InorderWalk walk(root);
+    for (Node* nodePtr = walk.next(); nodePtr != NULL; nodePtr = walk.next()) {
+        keyStream.str("");
+        keyStream << nodeValue(nodePtr);
+        const string& key = keyStream.str();
+        MappedTree::putUint32(bytes, static_cast<uint32_t>(key.size()));
+        outStream.write(bytes, 4);
+        outStream.write(key.data(), key.size());
+        offsets.push_back(position);
+        position += 4 + key.size();
+    }
+
+    for (size_t i = 0; i < offsets.size(); i++) {
+        MappedTree::putUint64(bytes, offsets[i]);
+        outStream.write(bytes, 8);
+    }
+    MappedTree::putUint64(bytes, position);
+    outStream.write(bytes, 8);
+    return outStream.good();
+}
+
+
+
+/*-------------------------------readBinary------------------------------------
+ * Pre: Takes in a reference to an istream, inStream, opened in binary mode
+ *      and positioned at the start of data written by writeBinary().
+ *
+ * Post: Deletes anything that was in the BinTree, then reads the header and
+ *       every record, turning each one back into a NodeData with NodeData's
+ *       string constructor. The records are already sorted, so the BinTree
+ *       is built balanced with one call to arrayToBSTree(), which also
+ *       checks the order. inStream is left just past the records. Returns
+ *       true if successful. Returns false, with the BinTree empty and
+ *       nothing leaked, if the header is wrong, the stream ends early or
+ *       the records are not strictly increasing.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+bool BasicBinTree<Key, Compare, Allocator>::readBinary(istream& inStream) {
+    makeEmpty();
+    char header[MappedTree::HEADER_SIZE];
+    if (!inStream.read(header, sizeof(header))
+            || memcmp(header, MappedTree::MAGIC
+                    , sizeof(MappedTree::MAGIC)) != 0
+            || MappedTree::getUint32(header + 4) != MappedTree::VERSION) {
+        return false;
+    }
+    uint64_t count = MappedTree::getUint64(header + 8);
+    if (count > INT_MAX) {
+        return false;
+    }
+
+    vector<Key> array;
+    array.reserve(min<uint64_t>(count, 1 << 20));   // count is not trusted
+    string key;
+    char bytes[4];
+    bool valid = true;
+    for (uint64_t i = 0; i < count && valid; i++) {
+        valid = static_cast<bool>(inStream.read(bytes, 4));
+        if (valid) {
+            key.resize(MappedTree::getUint32(bytes));
+            valid = key.empty()
+                    || static_cast<bool>(inStream.read(&key[0], key.size()));
+        }
+        if (valid) {
+            array.push_back(KeyTraits::fromString(key));
+        }
+    }
+
+    if (valid && !array.empty()) {
+        valid = arrayToBSTree(&array[0], static_cast<int>(array.size()), true);
+    }
+    if (!valid) {
+        for (size_t i = 0; i < array.size(); i++) {
+            KeyTraits::dispose(array[i]);
+        }
+    }
+    return valid;
+}
+
+
+
+/*------------------------- displaySideways -----------------------------------
+ * Pre: None.
+ *
+ * Post: Displays a binary tree as though you are viewing it from the side;
+ *      hard coded displaying to standard output.BinTree remains unchanged.
+ *----------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::displaySideways() const {
+    displaySideways(cout);
+}
+
+/*------------------------- displaySideways -----------------------------------
+ * Pre: Takes in a reference to an ostream, outStream.
+ *
+ * Post: Displays a binary tree on outStream as though you are viewing it from
+ *      the side. Lines are collected in a BlockBuffer, formatted with
+ *      outStream's locale and flags, and flushed once at the end instead of
+ *      once per line. BinTree remains unchanged.
+ *----------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::displaySideways(ostream& outStream)
+        const {
+    BlockBuffer buffer(outStream);
+    ostream blockStream(&buffer);
+    blockStream.copyfmt(outStream);
+    blockStream.tie(NULL);
+    sideways(blockStream, root, 0);
+    blockStream.flush();
+    outStream.flush();
+}
+
+/*----------------------------Private: Sideways -------------------------------
+ * Pre: Takes in a reference to an ostream, outStream, to print to. Takes in
+ *      a pointer to a Node, current, which is the current Node that is being
+ *      pointed to. Takes in an int, level, which indicates what level the
+ *      Node is at in the tree.
+ *
+ * Post: Prints out the BinTree sideways. The BinTree remains unchanged.
+ * --------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::sideways(ostream& outStream
+        , Node* current, int level) const {
+    vector<pair<Node*, int> > stack;
+    while (current != NULL || !stack.empty()) {
+        while (current != NULL) {
+            level++;
+            stack.push_back(make_pair(current, level));
+            current = current->right;
+        }
+        current = stack.back().first;
+        level = stack.back().second;
+        stack.pop_back();
+
+        // indent for readability, 4 spaces per depth level
+        for (int i = level; i >= 0; i--) {
+            outStream << "    ";
+        }
+
+        // display information of object
+        outStream << nodeValue(current) << '\n';
+        current = current->left;
+    }
+}
+
+
+/* -------------------------------makeEmpty------------------------------------
+ * Pre: None.
+ *
+ * Post: Deletes every Node in the tree along with its data. The NodeData are
+ *       deleted one by one, but the Nodes are freed a whole block at a time
+ *       by the pool. Keys that own nothing and need no destructor are not
+ *       walked at all. The BinTree becomes empty.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::makeEmpty() {
+    if (KeyTraits::OWNS || !is_trivially_destructible<Key>::value) {
+        destroyTree(root);
+    }
+    pool.releaseAll();
+    root = NULL;
+}
+
+
+/* --------------------------Private: destroyTree------------------------------
+ * Pre: Takes in a pointer to a Node, currentPtr, which points to a Node in the
+ *      BinTree. Takes in an int, depth, which is how many times the work has
+ *      been split across threads.
+ *
+ * Post: Deletes the NodeData held by every Node under currentPtr and
+ *      destroys the Node. While shouldFork() allows it, the right subtree is
+ *      done by another thread. The Nodes are left for the caller to give
+ *      back to the pool.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::destroyTree(Node* currentPtr
+        , int depth) {
+    if (shouldFork(currentPtr, depth)) {
+        future<void> rightDone = async(launch::async
+                , &BasicBinTree::destroyTree, this, currentPtr->right
+                , depth + 1);
+        destroyTree(currentPtr->left, depth + 1);
+        KeyTraits::dispose(currentPtr->data);
+        currentPtr->~Node();
+        rightDone.get();
+        return;
+    }
+
+    vector<Node*> stack;
+    stack.push_back(currentPtr);
+    while (!stack.empty()) {
+        currentPtr = stack.back();
+        stack.pop_back();
+        if (currentPtr != NULL) {
+            stack.push_back(currentPtr->right);
+            stack.push_back(currentPtr->left);
+            KeyTraits::dispose(currentPtr->data);
+            currentPtr->~Node();
+        }
+    }
+}
+
+
+
+/*----------------------------Private: newNode---------------------------------
+ * Pre: Takes in a Key, data, that the new Node will own.
+ *
+ * Post: Takes a Node from the pool and returns it as a leaf holding data.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::Node*
+        BasicBinTree<Key, Compare, Allocator>::newNode(Key data) {
+    return newNode(std::move(data), pool);
+}
+
+
+
+/*----------------------------Private: newNode---------------------------------
+ * Pre: Takes in a Key, data, that the new Node will own. Takes in a
+ *      reference to a NodePool, nodePool.
+ *
+ * Post: Takes a Node from nodePool, builds it in place and returns it as a
+ *       leaf holding data.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+typename BasicBinTree<Key, Compare, Allocator>::Node*
+        BasicBinTree<Key, Compare, Allocator>::newNode(Key data
+        , Allocator& nodePool) {
+    Node* nodePtr = static_cast<Node*>(nodePool.allocate());
+    STATS_ALLOCATE();
+    ::new (static_cast<void*>(nodePtr)) Node;
+    nodePtr->data = std::move(data);
+    nodePtr->setPrefix(prefixOf(nodeValue(nodePtr)));
+    nodePtr->left = NULL;
+    nodePtr->right = NULL;
+    nodePtr->parent = NULL;
+    nodePtr->height = 1;
+    nodePtr->size = 1;
+    return nodePtr;
+}
+
+
+
+/*----------------------------Private: freeNode--------------------------------
+ * Pre: Takes in a pointer to a Node, nodePtr, taken from nodePool and no
+ *      longer linked into any tree. Takes in a reference to a NodePool,
+ *      nodePool.
+ *
+ * Post: Destroys whatever is left in nodePtr's data and gives the Node back
+ *       to nodePool.
+ *---------------------------------------------------------------------------*/
+template <class Key, class Compare, class Allocator>
+void BasicBinTree<Key, Compare, Allocator>::freeNode(Node* nodePtr
+        , Allocator& nodePool) {
+    nodePtr->~Node();
+    nodePool.release(nodePtr);
+}
+
+#undef STATS_PROBE
+#undef STATS_COMPARE
+#undef STATS_VISIT
+#undef STATS_ALLOCATE
@@ -0,0 +1,163 @@
+#include "bintreestats.h"
+#include <cstddef>
+
+thread_local StatsProbe* StatsProbe::current = NULL;
+
+
+/*----------------------------OperationCounters Constructor--------------------
+ * Pre: None.
+ *
+ * Post: Creates counters that are all 0.
+ *---------------------------------------------------------------------------*/
+OperationCounters::OperationCounters() {
+    reset();
+}
+
+
+
+/*--------------------------------------add------------------------------------
+ * Pre: Takes in the counts for one finished operation: comparisonCount,
+ *      visitCount and allocationCount, the deepest Node it reached, depth,
+ *      and how long it took in nanoseconds.
+ *
+ * Post: Adds the operation to the totals and to its latency bucket, and
+ *       raises maxDepth if depth is deeper. Safe to call from many threads
+ *       at once.
+ *---------------------------------------------------------------------------*/
+void OperationCounters::add(uint64_t comparisonCount, uint64_t visitCount
+        , uint64_t allocationCount, int depth, uint64_t nanoseconds) {
+    calls.fetch_add(1, std::memory_order_relaxed);
+    comparisons.fetch_add(comparisonCount, std::memory_order_relaxed);
+    nodesVisited.fetch_add(visitCount, std::memory_order_relaxed);
+    allocations.fetch_add(allocationCount, std::memory_order_relaxed);
+
+    int deepest = maxDepth.load(std::memory_order_relaxed);
+    while (depth > deepest && !maxDepth.compare_exchange_weak(deepest, depth
+            , std::memory_order_relaxed)) {
+    }
+
+    int bucket = 0;
+    while (bucket < LATENCY_BUCKETS - 1 && (nanoseconds >> bucket) != 0) {
+        bucket++;
+    }
+    latency[bucket].fetch_add(1, std::memory_order_relaxed);
+}
+
+
+
+/*-----------------------------------snapshot----------------------------------
+ * Pre: None.
+ *
+ * Post: Returns a copy of every counter. Counters that are being added to
+ *       at the same time may be read a moment apart from each other.
+ *---------------------------------------------------------------------------*/
+OperationStats OperationCounters::snapshot() const {
+    OperationStats stats;
+    stats.calls = calls.load(std::memory_order_relaxed);
+    stats.comparisons = comparisons.load(std::memory_order_relaxed);
+    stats.nodesVisited = nodesVisited.load(std::memory_order_relaxed);
+    stats.allocations = allocations.load(std::memory_order_relaxed);
+    stats.maxDepth = maxDepth.load(std::memory_order_relaxed);
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        stats.latency[i] = latency[i].load(std::memory_order_relaxed);
+    }
+    return stats;
+}
+
+
+
+/*------------------------------------reset------------------------------------
+ * Pre: None.
+ *
+ * Post: Sets every counter back to 0.
+ *---------------------------------------------------------------------------*/
+void OperationCounters::reset() {
+    calls.store(0, std::memory_order_relaxed);
+    comparisons.store(0, std::memory_order_relaxed);
+    nodesVisited.store(0, std::memory_order_relaxed);
+    allocations.store(0, std::memory_order_relaxed);
+    maxDepth.store(0, std::memory_order_relaxed);
+    for (int i = 0; i < LATENCY_BUCKETS; i++) {
+        latency[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+
+
+/*-------------------------------StatsProbe Constructor------------------------
+ * Pre: Takes in a reference to the OperationCounters, counters, that the
+ *      operation being measured belongs to.
+ *
+ * Post: Becomes this thread's probe, remembering the one it replaced, and
+ *       starts the clock.
+ *---------------------------------------------------------------------------*/
+StatsProbe::StatsProbe(OperationCounters& counters) : counters(counters) {
+    outer = current;
+    current = this;
+    comparisons = 0;
+    nodesVisited = 0;
+    allocations = 0;
+    maxDepth = 0;
+    start = std::chrono::steady_clock::now();
+}
+
+
+
+/*-------------------------------StatsProbe Destructor-------------------------
+ * Pre: None.
+ *
+ * Post: Stops the clock, adds everything this probe saw to its counters and
+ *       makes the outer probe this thread's probe again.
+ *---------------------------------------------------------------------------*/
+StatsProbe::~StatsProbe() {
+    std::chrono::steady_clock::duration elapsed
+            = std::chrono::steady_clock::now() - start;
+    counters.add(comparisons, nodesVisited, allocations, maxDepth
+            , std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed)
+                    .count());
+    current = outer;
+}
+
+
+
+/*--------------------------------StatsProbe::compare--------------------------
+ * Pre: None.
+ *
+ * Post: Counts one comparison for this thread's probe, if there is one.
+ *---------------------------------------------------------------------------*/
+void StatsProbe::compare() {
+    if (current != NULL) {
+        current->comparisons++;
+    }
+}
+
+
+
+/*--------------------------------StatsProbe::visit----------------------------
+ * Pre: Takes in an int, depth, which is how deep the visited Node is. The
+ *      root is at depth 1.
+ *
+ * Post: Counts one Node visited for this thread's probe, if there is one,
+ *       and remembers depth if it is the deepest so far.
+ *---------------------------------------------------------------------------*/
+void StatsProbe::visit(int depth) {
+    if (current != NULL) {
+        current->nodesVisited++;
+        if (depth > current->maxDepth) {
+            current->maxDepth = depth;
+        }
+    }
+}
+
+
+
+/*------------------------------StatsProbe::allocate---------------------------
+ * Pre: None.
+ *
+ * Post: Counts one Node allocated for this thread's probe, if there is one.
+ *---------------------------------------------------------------------------*/
+void StatsProbe::allocate() {
+    if (current != NULL) {
+        current->allocations++;
+    }
+}
@@ -0,0 +1,151 @@
+#ifndef BINTREESTATS_H
+#define BINTREESTATS_H
+
+#include <atomic>
+#include <chrono>
+#include <stdint.h>
+
+/* These types describe what a BinTree is doing and what shape it is in.
+ *
+ * OperationStats, BinTreeStats and ShapeReport are plain snapshots that can
+ * be copied around and compared over time. ShapeReport is always available
+ * from BinTree::shapeReport().
+ *
+ * OperationCounters and StatsProbe do the counting. A BinTree only holds
+ * counters, and only calls into them, when it is built with BINTREE_STATS
+ * defined. Without it, none of this code is on any of BinTree's paths. Every
+ * file that includes bintree.h must agree on BINTREE_STATS.
+ *
+ * While a StatsProbe is alive it is the probe for its thread. The helpers
+ * that do the work (findNode, insertHelper, newNode, ...) report to it
+ * through the static methods without knowing which operation called them,
+ * and the probe adds everything to its counters when it goes away.
+ * */
+
+// Latency bucket i counts operations that took fewer than 2^i nanoseconds
+// (and at least 2^(i-1)). The last bucket also takes everything slower.
+static const int LATENCY_BUCKETS = 32;
+
+
+//----------------------------OperationStats-----------------------------------
+// Totals for one kind of operation since the counters were last reset.
+struct OperationStats {
+    uint64_t calls;                         // operations finished
+    uint64_t comparisons;                   // NodeData comparisons made
+    uint64_t nodesVisited;                  // Nodes looked at
+    uint64_t allocations;                   // Nodes taken from the pool
+    int maxDepth;                           // deepest Node any call reached
+    uint64_t latency[LATENCY_BUCKETS];      // calls per latency bucket
+};
+
+
+//----------------------------BinTreeStats-------------------------------------
+// One OperationStats for each instrumented BinTree operation.
+struct BinTreeStats {
+    OperationStats insert;
+    OperationStats retrieve;
+    OperationStats getHeight;
+    OperationStats remove;
+};
+
+
+//----------------------------ShapeReport--------------------------------------
+// The shape of a BinTree at one moment. balanceCounts[b + 2] is how many
+// Nodes have a left height minus right height of b, with b clamped to -2..2,
+// so the first and last entries count every Node that is out of AVL balance.
+struct ShapeReport {
+    int size;                               // Nodes in the BinTree
+    int height;                             // height of the BinTree
+    int balancedHeight;                     // height if it were balanced
+    double averageDepth;                    // mean depth, root is depth 1
+    int balanceCounts[5];                   // Nodes per balance factor
+};
+
+
+/* This class, OperationCounters, collects the totals for one kind of
+ * operation. Every counter is atomic, so threads that read a BinTree at the
+ * same time can all report to it.
+ * */
+class OperationCounters {
+
+private:
+    std::atomic<uint64_t> calls;
+    std::atomic<uint64_t> comparisons;
+    std::atomic<uint64_t> nodesVisited;
+    std::atomic<uint64_t> allocations;
+    std::atomic<int> maxDepth;
+    std::atomic<uint64_t> latency[LATENCY_BUCKETS];
+
+    // Counters belong to one BinTree and are never copied with it.
+    OperationCounters(const OperationCounters&);
+    OperationCounters& operator=(const OperationCounters&);
+
+public:
+
+    //---------------------------Constructor-----------------------------------
+    // Creates counters that are all 0.
+    OperationCounters();
+
+
+    //---------------------------add-------------------------------------------
+    // Adds one finished operation with the given counts and latency.
+    void add(uint64_t comparisonCount, uint64_t visitCount
+            , uint64_t allocationCount, int depth, uint64_t nanoseconds);
+
+
+    //---------------------------snapshot--------------------------------------
+    // Returns a copy of the totals.
+    OperationStats snapshot() const;
+
+
+    //---------------------------reset-----------------------------------------
+    // Sets every counter back to 0.
+    void reset();
+};
+
+
+/* This class, StatsProbe, measures one BinTree operation from its
+ * construction to its destruction and then adds what it saw to a set of
+ * OperationCounters. Probes on the same thread nest; the innermost one is
+ * the one that is reported to.
+ * */
+class StatsProbe {
+
+private:
+    OperationCounters& counters;            // where the totals go
+    StatsProbe* outer;                      // probe this one replaced
+    std::chrono::steady_clock::time_point start;
+    uint64_t comparisons;
+    uint64_t nodesVisited;
+    uint64_t allocations;
+    int maxDepth;
+
+    static thread_local StatsProbe* current;    // innermost probe, or NULL
+
+    // A probe only makes sense on the stack of the operation it measures.
+    StatsProbe(const StatsProbe&);
+    StatsProbe& operator=(const StatsProbe&);
+
+public:
+
+    //---------------------------Constructor-----------------------------------
+    // Starts the clock and becomes this thread's probe.
+    explicit StatsProbe(OperationCounters& counters);
+
+
+    //---------------------------Destructor------------------------------------
+    // Stops the clock, adds the operation to the counters and hands the
+    // thread back to the outer probe.
+    ~StatsProbe();
+
+
+    //---------------------------compare / visit / allocate--------------------
+    // Tell this thread's probe, if there is one, about one comparison, one
+    // Node visited at the given depth (the root is depth 1), or one Node
+    // allocated. Do nothing if there is no probe.
+    static void compare();
+    static void visit(int depth);
+    static void allocate();
+};
+
+#endif
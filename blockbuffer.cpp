@@ -0,0 +1,152 @@
+#include "blockbuffer.h"
+#include <cerrno>
+#include <unistd.h>
+
+// Size of the block that tree output is collected in before it is written.
+static const size_t OUTPUT_BLOCK_SIZE = 64 * 1024;
+
+
+/*-----------------------------Static: outputBlock-----------------------------
+ * The block each thread collects tree output in. It is allocated the first
+ * time the thread prints a non-empty tree and then reused by every
+ * BlockBuffer on that thread. outputBlockBusy is set while a BlockBuffer is
+ * using it.
+ *---------------------------------------------------------------------------*/
+static thread_local std::vector<char> outputBlock;
+static thread_local bool outputBlockBusy = false;
+
+
+
+/*------------------------------ostream Constructor----------------------------
+ * Pre: Takes in a reference to an ostream, target, that outlives this
+ *      BlockBuffer.
+ *
+ * Post: Creates a BlockBuffer that hands its output to target. No block is
+ *       claimed yet.
+ *---------------------------------------------------------------------------*/
+BlockBuffer::BlockBuffer(std::ostream& target)
+        : block(NULL), stream(&target), fd(-1), failed(false)
+        , ownsThreadBlock(false) {
+}
+
+
+
+/*--------------------------------fd Constructor-------------------------------
+ * Pre: Takes in an int, fd, which is a file descriptor open for writing.
+ *
+ * Post: Creates a BlockBuffer that writes its output to fd. No block is
+ *       claimed yet.
+ *---------------------------------------------------------------------------*/
+BlockBuffer::BlockBuffer(int fd)
+        : block(NULL), stream(NULL), fd(fd), failed(false)
+        , ownsThreadBlock(false) {
+}
+
+
+
+/*---------------------------------Destructor----------------------------------
+ * Pre: None.
+ *
+ * Post: Writes out whatever is left in the block and hands the thread's
+ *       block back if this BlockBuffer was using it.
+ *---------------------------------------------------------------------------*/
+BlockBuffer::~BlockBuffer() {
+    flushBlock();
+    if (ownsThreadBlock) {
+        outputBlockBusy = false;
+    }
+}
+
+
+
+/*-----------------------------------good--------------------------------------
+ * Pre: None.
+ *
+ * Post: Returns true if every write so far has succeeded.
+ *---------------------------------------------------------------------------*/
+bool BlockBuffer::good() const {
+    return !failed;
+}
+
+
+
+/*---------------------------------overflow------------------------------------
+ * Pre: Takes in an int, c, which is the character that did not fit, or eof.
+ *
+ * Post: Claims a block if there is none yet, otherwise writes the full one
+ *       out. Then puts c at the start of the block. Returns eof if the write
+ *       failed.
+ *---------------------------------------------------------------------------*/
+int BlockBuffer::overflow(int c) {
+    if (block == NULL) {
+        claimBlock();
+    } else if (!flushBlock()) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+
+
+/*-----------------------------------sync--------------------------------------
+ * Pre: None.
+ *
+ * Post: Writes out everything in the block. Returns 0, or -1 if a write has
+ *       failed.
+ *---------------------------------------------------------------------------*/
+int BlockBuffer::sync() {
+    return flushBlock() ? 0 : -1;
+}
+
+
+
+/*-----------------------------Private: claimBlock-----------------------------
+ * Pre: No block has been claimed yet.
+ *
+ * Post: Takes this thread's outputBlock, or spareBlock if another BlockBuffer
+ *       on the thread has it, sizes it to OUTPUT_BLOCK_SIZE and makes it the
+ *       put area.
+ *---------------------------------------------------------------------------*/
+void BlockBuffer::claimBlock() {
+    if (!outputBlockBusy) {
+        outputBlockBusy = true;
+        ownsThreadBlock = true;
+        block = &outputBlock;
+    } else {
+        block = &spareBlock;
+    }
+    block->resize(OUTPUT_BLOCK_SIZE);
+    setp(&(*block)[0], &(*block)[0] + block->size());
+}
+
+
+
+/*-----------------------------Private: flushBlock-----------------------------
+ * Pre: None.
+ *
+ * Post: Writes everything in the put area to the stream, or to fd with
+ *       write() until all of it is out, retrying after EINTR. Empties the
+ *       put area. Returns false if this or an earlier write failed.
+ *---------------------------------------------------------------------------*/
+bool BlockBuffer::flushBlock() {
+    const char* next = pbase();
+    size_t left = pptr() - pbase();
+    if (stream != NULL && left > 0) {
+        failed = failed || !stream->write(next, left);
+    }
+    while (stream == NULL && left > 0 && !failed) {
+        ssize_t written = ::write(fd, next, left);
+        if (written >= 0) {
+            next += written;
+            left -= written;
+        } else if (errno != EINTR) {
+            failed = true;
+        }
+    }
+    setp(pbase(), epptr());
+    return !failed;
+}
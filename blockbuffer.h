@@ -0,0 +1,76 @@
+#ifndef BLOCKBUFFER_H
+#define BLOCKBUFFER_H
+
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+/* This class, BlockBuffer, is a stream buffer that collects output in one
+ * OUTPUT_BLOCK_SIZE block and only hands it on, to an ostream or a file
+ * descriptor, when the block is full or the stream is flushed. Printing a
+ * tree through it costs one write per block instead of one per NodeData, and
+ * nothing is allocated per NodeData or per call.
+ *
+ * Each thread has one block that every BlockBuffer on it reuses. It is
+ * allocated the first time the thread prints something and only claimed once
+ * the first character arrives, so printing an empty tree does not touch it.
+ * A BlockBuffer that starts in the middle of another's output (from a
+ * NodeData's own operator<<, say) takes a block of its own instead.
+ * */
+class BlockBuffer : public std::streambuf {
+
+private:
+    std::vector<char>* block;               // output not yet written
+    std::vector<char> spareBlock;           // used if the thread's is busy
+    std::ostream* stream;                   // target, or NULL to use fd
+    int fd;                                 // target if stream is NULL
+    bool failed;                            // a write has failed
+    bool ownsThreadBlock;                   // block is the thread's block
+
+
+    //---------------------------claimBlock------------------------------------
+    // Points block at this thread's block, or at spareBlock if another
+    // BlockBuffer is using it, and starts filling it.
+    void claimBlock();
+
+
+    //---------------------------flushBlock------------------------------------
+    // Writes out everything in the block and empties it. Returns false if
+    // this or an earlier write failed.
+    bool flushBlock();
+
+
+    // Copying a BlockBuffer would write the same output twice.
+    BlockBuffer(const BlockBuffer&);
+    BlockBuffer& operator=(const BlockBuffer&);
+
+
+protected:
+
+    //---------------------------overflow / sync-------------------------------
+    // The streambuf hooks. overflow() is called when the block is full (or
+    // not claimed yet), sync() when the stream is flushed.
+    int overflow(int c);
+    int sync();
+
+
+public:
+
+    //---------------------------Constructors----------------------------------
+    // Create a BlockBuffer that writes to target, or to the file descriptor
+    // fd with write().
+    explicit BlockBuffer(std::ostream& target);
+    explicit BlockBuffer(int fd);
+
+
+    // ---------------------------Destructor----------------------------------
+    // Writes out whatever is left in the block.
+    ~BlockBuffer();
+
+
+    // ---------------------------good----------------------------------------
+    // Returns false if any write has failed.
+    bool good() const;
+};
+
+#endif
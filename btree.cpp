@@ -0,0 +1,422 @@
+#include "btree.h"
+#include <algorithm>
+#include <cstring>
+#include <ostream>
+#include <streambuf>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define BTREE_X86_SIMD
+#include <immintrin.h>
+#endif
+
+
+/*-------------------------------Static: PrefixBuffer--------------------------
+ * A stream buffer that keeps the first 8 characters written to it and drops
+ * the rest, so prefixOf() can take a NodeData's prefix through its output
+ * operator without building the whole string. Each thread has one, with an
+ * ostream on it, made the first time the thread needs a prefix.
+ *---------------------------------------------------------------------------*/
+class PrefixBuffer : public streambuf {
+public:
+    unsigned char bytes[8];                 // first bytes written, else 0
+    size_t used;                            // how many bytes are kept
+
+    void reset() {
+        memset(bytes, 0, sizeof(bytes));
+        used = 0;
+    }
+
+protected:
+    int overflow(int c) {
+        if (!traits_type::eq_int_type(c, traits_type::eof())
+                && used < sizeof(bytes)) {
+            bytes[used++] = static_cast<unsigned char>(c);
+        }
+        return traits_type::not_eof(c);
+    }
+
+    streamsize xsputn(const char* text, streamsize length) {
+        size_t kept = min(static_cast<size_t>(length), sizeof(bytes) - used);
+        memcpy(bytes + used, text, kept);
+        used += kept;
+        return length;
+    }
+};
+
+static thread_local PrefixBuffer prefixBuffer;
+static thread_local ostream prefixStream(&prefixBuffer);
+
+
+
+/*-------------------------------Static: rankPrefixes--------------------------
+ * Pre: Takes in a read-only pointer, prefixes, to the 64-byte aligned
+ *      prefixes of a Node, an int, count, of keys in use, and the prefix of
+ *      a target. Takes in two references to ints, less and notGreater.
+ *
+ * Post: Sets less to how many of the first count prefixes are less than
+ *       target, and notGreater to how many are not greater. The prefixes are
+ *       sorted, so keys below less are less than the target, keys from
+ *       notGreater on are greater, and only the keys in between can equal
+ *       it. rankScalar() looks at one prefix at a time. rankSse42() and
+ *       rankAvx2() compare two or four at once, reading whole vectors up to
+ *       count rounded up, which stays inside the Node's MAX_KEYS + 1 slots,
+ *       and mask off the slots past count.
+ *---------------------------------------------------------------------------*/
+typedef void (*PrefixRanker)(const int64_t* prefixes, int count
+        , int64_t target, int& less, int& notGreater);
+
+static void rankScalar(const int64_t* prefixes, int count, int64_t target
+        , int& less, int& notGreater) {
+    less = 0;
+    notGreater = 0;
+    for (int i = 0; i < count; i++) {
+        less += prefixes[i] < target;
+        notGreater += prefixes[i] <= target;
+    }
+}
+
+#ifdef BTREE_X86_SIMD
+__attribute__((target("sse4.2")))
+static void rankSse42(const int64_t* prefixes, int count, int64_t target
+        , int& less, int& notGreater) {
+    __m128i key = _mm_set1_epi64x(target);
+    unsigned lessMask = 0;
+    unsigned greaterMask = 0;
+    for (int i = 0; i < count; i += 2) {
+        __m128i lanes = _mm_load_si128(
+                reinterpret_cast<const __m128i*>(prefixes + i));
+        lessMask |= static_cast<unsigned>(_mm_movemask_pd(
+                _mm_castsi128_pd(_mm_cmpgt_epi64(key, lanes)))) << i;
+        greaterMask |= static_cast<unsigned>(_mm_movemask_pd(
+                _mm_castsi128_pd(_mm_cmpgt_epi64(lanes, key)))) << i;
+    }
+    unsigned inUse = (1u << count) - 1;
+    less = __builtin_popcount(lessMask & inUse);
+    notGreater = count - __builtin_popcount(greaterMask & inUse);
+}
+
+__attribute__((target("avx2")))
+static void rankAvx2(const int64_t* prefixes, int count, int64_t target
+        , int& less, int& notGreater) {
+    __m256i key = _mm256_set1_epi64x(target);
+    unsigned lessMask = 0;
+    unsigned greaterMask = 0;
+    for (int i = 0; i < count; i += 4) {
+        __m256i lanes = _mm256_load_si256(
+                reinterpret_cast<const __m256i*>(prefixes + i));
+        lessMask |= static_cast<unsigned>(_mm256_movemask_pd(
+                _mm256_castsi256_pd(_mm256_cmpgt_epi64(key, lanes)))) << i;
+        greaterMask |= static_cast<unsigned>(_mm256_movemask_pd(
+                _mm256_castsi256_pd(_mm256_cmpgt_epi64(lanes, key)))) << i;
+    }
+    unsigned inUse = (1u << count) - 1;
+    less = __builtin_popcount(lessMask & inUse);
+    notGreater = count - __builtin_popcount(greaterMask & inUse);
+}
+#endif
+
+
+
+/*------------------------------Static: chooseRanker---------------------------
+ * Pre: None.
+ *
+ * Post: Returns the widest rankPrefixes() version this CPU can run. Called
+ *       once, the first time a BTree searches a Node.
+ *---------------------------------------------------------------------------*/
+static PrefixRanker chooseRanker() {
+#ifdef BTREE_X86_SIMD
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) {
+        return rankAvx2;
+    }
+    if (__builtin_cpu_supports("sse4.2")) {
+        return rankSse42;
+    }
+#endif
+    return rankScalar;
+}
+
+
+
+/*-----------------------------Empty Constructor-------------------------------
+ * Pre: None
+ *
+ * Post: Creates an empty BTree.
+ *---------------------------------------------------------------------------*/
+BTree::BTree() : pool(sizeof(Node), alignof(Node)) {
+    root = NULL;
+    height = 0;
+}
+
+
+
+/*---------------------------------Destructor----------------------------------
+ * Pre: None
+ *
+ * Post: Deletes every NodeData and frees every Node.
+ *---------------------------------------------------------------------------*/
+BTree::~BTree() {
+    makeEmpty();
+}
+
+
+
+/*---------------------------------isEmpty-------------------------------------
+ * Pre: None.
+ *
+ * Post: Returns true if the BTree is empty. Returns false if it is not.
+ *---------------------------------------------------------------------------*/
+bool BTree::isEmpty() const {
+    return root == NULL;
+}
+
+
+
+/* -------------------------------makeEmpty------------------------------------
+ * Pre: None.
+ *
+ * Post: Deletes the NodeData held by every Node, walking the Nodes with an
+ *       explicit stack, then frees the Nodes a block at a time with the
+ *       pool. The BTree becomes empty.
+ *---------------------------------------------------------------------------*/
+void BTree::makeEmpty() {
+    vector<Node*> stack;
+    if (root != NULL) {
+        stack.push_back(root);
+    }
+    while (!stack.empty()) {
+        Node* nodePtr = stack.back();
+        stack.pop_back();
+        for (int i = 0; i < nodePtr->count; i++) {
+            delete nodePtr->keys[i];
+        }
+        if (!nodePtr->leaf) {
+            for (int i = 0; i <= nodePtr->count; i++) {
+                stack.push_back(nodePtr->children[i]);
+            }
+        }
+    }
+    pool.releaseAll();
+    root = NULL;
+    height = 0;
+}
+
+
+
+/*----------------------------------insert-------------------------------------
+ * Pre: Takes in a pointer to a NodeData, insertPtr, which is the value that
+ *      will be inserted into the BTree.
+ *
+ * Post: Inserts insertPtr in one pass from the root down. Any full Node on
+ *       the way is split before it is entered, so there is always room for
+ *       the key that moves up. Returns true if insertPtr was inserted and is
+ *       now owned by the BTree. Returns false if its value was already in
+ *       the BTree; the BTree may have split Nodes on the way but holds the
+ *       same data.
+ *---------------------------------------------------------------------------*/
+bool BTree::insert(NodeData* insertPtr) {
+    if (root == NULL) {
+        root = newNode(true);
+        height = 1;
+    }
+    if (root->count == MAX_KEYS) {
+        Node* newRootPtr = newNode(false);
+        newRootPtr->children[0] = root;
+        root = newRootPtr;
+        height++;
+        splitChild(root, 0);
+    }
+
+    Node* currentPtr = root;
+    int64_t insertPrefix = prefixOf(*insertPtr);
+    int index;
+    while (true) {
+        if (findSlot(currentPtr, *insertPtr, insertPrefix, index)) {
+            return false;
+        }
+        if (currentPtr->leaf) {
+            break;
+        }
+        if (currentPtr->children[index]->count == MAX_KEYS) {
+            splitChild(currentPtr, index);
+            if (*currentPtr->keys[index] == *insertPtr) {
+                return false;
+            } else if (*currentPtr->keys[index] < *insertPtr) {
+                index++;
+            }
+        }
+        currentPtr = currentPtr->children[index];
+    }
+
+    for (int i = currentPtr->count; i > index; i--) {
+        currentPtr->keys[i] = currentPtr->keys[i - 1];
+        currentPtr->prefixes[i] = currentPtr->prefixes[i - 1];
+    }
+    currentPtr->keys[index] = insertPtr;
+    currentPtr->prefixes[index] = insertPrefix;
+    currentPtr->count++;
+    return true;
+}
+
+
+
+/*-------------------------------retrieve-------------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target, which is the
+ *      value to look for. Takes in a pointer reference to a NodeData,
+ *      nodeDataPtr.
+ *
+ * Post: Makes nodeDataPtr point to the NodeData in the BTree that equals
+ *       target and returns true. If target is not in the BTree, sets
+ *       nodeDataPtr to NULL and returns false.
+ *---------------------------------------------------------------------------*/
+bool BTree::retrieve(const NodeData& target, NodeData*& nodeDataPtr) const {
+    const Node* currentPtr = root;
+    int64_t targetPrefix = prefixOf(target);
+    while (currentPtr != NULL) {
+        int index;
+        if (findSlot(currentPtr, target, targetPrefix, index)) {
+            nodeDataPtr = currentPtr->keys[index];
+            return true;
+        }
+        currentPtr = currentPtr->leaf ? NULL : currentPtr->children[index];
+    }
+    nodeDataPtr = NULL;
+    return false;
+}
+
+
+
+/*--------------------------------getHeight------------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target.
+ *
+ * Post: Returns the height of the Node that holds target, counted in Nodes
+ *       from the bottom of the BTree, so a leaf is 1. Every leaf is on the
+ *       same level, so this is the BTree's height minus the depth at which
+ *       target was found. Returns 0 if target is not in the BTree.
+ *---------------------------------------------------------------------------*/
+int BTree::getHeight(const NodeData& target) const {
+    const Node* currentPtr = root;
+    int64_t targetPrefix = prefixOf(target);
+    int level = height;
+    while (currentPtr != NULL) {
+        int index;
+        if (findSlot(currentPtr, target, targetPrefix, index)) {
+            return level;
+        }
+        currentPtr = currentPtr->leaf ? NULL : currentPtr->children[index];
+        level--;
+    }
+    return 0;
+}
+
+
+
+/*----------------------------Private: newNode---------------------------------
+ * Pre: Takes in a bool, leaf, which is true if the Node will have no
+ *      children.
+ *
+ * Post: Takes a Node from the pool and returns it with no keys. The
+ *       prefixes are zeroed so a vector search never reads garbage from the
+ *       slots past count.
+ *---------------------------------------------------------------------------*/
+BTree::Node* BTree::newNode(bool leaf) {
+    Node* nodePtr = static_cast<Node*>(pool.allocate());
+    memset(nodePtr->prefixes, 0, sizeof(nodePtr->prefixes));
+    nodePtr->count = 0;
+    nodePtr->leaf = leaf;
+    return nodePtr;
+}
+
+
+
+/*----------------------------Private: prefixOf--------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, value.
+ *
+ * Post: Writes value with its output operator into this thread's
+ *       PrefixBuffer, which keeps only the first 8 bytes, and returns them
+ *       as a big-endian number (shorter text is padded with zeros) with the
+ *       top bit flipped. Two prefixes then compare as signed numbers the way
+ *       the texts compare as strings, as far as their first 8 bytes go.
+ *---------------------------------------------------------------------------*/
+int64_t BTree::prefixOf(const NodeData& value) {
+    prefixBuffer.reset();
+    prefixStream.clear();
+    prefixStream << value;
+    uint64_t prefix = 0;
+    for (size_t i = 0; i < sizeof(prefixBuffer.bytes); i++) {
+        prefix = (prefix << 8) | prefixBuffer.bytes[i];
+    }
+    return static_cast<int64_t>(prefix ^ (static_cast<uint64_t>(1) << 63));
+}
+
+
+
+/*----------------------------Private: findSlot--------------------------------
+ * Pre: Takes in a read-only pointer to a Node, nodePtr, that is not NULL.
+ *      Takes in a read-only reference to a NodeData, target, and
+ *      targetPrefix, which is prefixOf(target). Takes in a reference to an
+ *      int, index.
+ *
+ * Post: Ranks targetPrefix among the prefixes of nodePtr with the fastest
+ *       rankPrefixes() this CPU has, which leaves only the keys that share
+ *       target's prefix. Binary searches those few as NodeData. Sets index
+ *       to the first key that is not less than target (count if there is
+ *       none), which is also the child to descend into. Returns true if
+ *       that key equals target. Returns false otherwise.
+ *---------------------------------------------------------------------------*/
+bool BTree::findSlot(const Node* nodePtr, const NodeData& target
+        , int64_t targetPrefix, int& index) {
+    static const PrefixRanker rankPrefixes = chooseRanker();
+    int low;
+    int tieEnd;
+    rankPrefixes(nodePtr->prefixes, nodePtr->count, targetPrefix, low, tieEnd);
+    int high = tieEnd;
+    while (low < high) {
+        int middle = (low + high) / 2;
+        if (*nodePtr->keys[middle] < target) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    index = low;
+    return low < tieEnd && !(target < *nodePtr->keys[low]);
+}
+
+
+
+/*---------------------------Private: splitChild-------------------------------
+ * Pre: Takes in a pointer to a Node, parentPtr, that is not full. Takes in
+ *      an int, index, of a child of parentPtr that is full.
+ *
+ * Post: Moves the upper MIN_DEGREE - 1 keys (and their children) of the
+ *       child into a new sibling, then moves the child's middle key up into
+ *       parentPtr at index with the sibling to its right.
+ *---------------------------------------------------------------------------*/
+void BTree::splitChild(Node* parentPtr, int index) {
+    Node* childPtr = parentPtr->children[index];
+    Node* siblingPtr = newNode(childPtr->leaf);
+
+    siblingPtr->count = MIN_DEGREE - 1;
+    for (int i = 0; i < MIN_DEGREE - 1; i++) {
+        siblingPtr->keys[i] = childPtr->keys[i + MIN_DEGREE];
+        siblingPtr->prefixes[i] = childPtr->prefixes[i + MIN_DEGREE];
+    }
+    if (!childPtr->leaf) {
+        for (int i = 0; i < MIN_DEGREE; i++) {
+            siblingPtr->children[i] = childPtr->children[i + MIN_DEGREE];
+        }
+    }
+    childPtr->count = MIN_DEGREE - 1;
+
+    for (int i = parentPtr->count; i > index; i--) {
+        parentPtr->children[i + 1] = parentPtr->children[i];
+        parentPtr->keys[i] = parentPtr->keys[i - 1];
+        parentPtr->prefixes[i] = parentPtr->prefixes[i - 1];
+    }
+    parentPtr->children[index + 1] = siblingPtr;
+    parentPtr->keys[index] = childPtr->keys[MIN_DEGREE - 1];
+    parentPtr->prefixes[index] = childPtr->prefixes[MIN_DEGREE - 1];
+    parentPtr->count++;
+}
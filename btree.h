@@ -0,0 +1,114 @@
+#ifndef BTREE_H
+#define BTREE_H
+
+#include "nodedata.h"
+#include "nodepool.h"
+#include <stdint.h>
+
+/* This class, BTree, is a search tree with wide nodes. Each Node holds up to
+ * MAX_KEYS NodeData in sorted order and one more child than that, so a
+ * lookup visits about log16(n) Nodes instead of the log2(n) a BinTree
+ * visits. All leaves are on the same level, so the BTree is balanced no
+ * matter what order the data arrives in.
+ *
+ * It has the same insert, retrieve and getHeight methods as BinTree, and
+ * like a BinTree it owns every NodeData that was inserted. Nodes come from a
+ * NodePool and each one starts on a cache line.
+ *
+ * Next to every key a Node keeps its prefix: the first 8 bytes of the text
+ * the NodeData's output operator writes, read as one big-endian number. A
+ * NodeData compares as the string it writes, so the prefixes are sorted
+ * like the keys. They fill the Node's first two cache lines, and a search
+ * compares the target's prefix with all of them at once using AVX2 or
+ * SSE4.2, or one at a time on a CPU with neither. Only keys whose prefix
+ * ties with the target's are loaded and compared as NodeData.
+ * */
+class BTree {
+
+private:
+    static const int MIN_DEGREE = 8;                  // fewest children
+    static const int MAX_KEYS = 2 * MIN_DEGREE - 1;   // most keys per Node
+
+    struct Node {
+        alignas(64) int64_t prefixes[MAX_KEYS + 1];  // prefixOf(keys[i])
+        int count;                          // keys in use
+        bool leaf;                          // true if no children
+        NodeData* keys[MAX_KEYS];           // sorted keys
+        Node* children[MAX_KEYS + 1];       // children[i] < keys[i]
+    };
+    Node* root;                             // root of the tree
+    int height;                             // levels, 0 if empty
+    NodePool pool;                          // memory for every Node
+
+
+    //----------------------------newNode--------------------------------------
+    // Takes a Node from the pool and makes it an empty Node.
+    Node* newNode(bool leaf);
+
+
+    //----------------------------prefixOf-------------------------------------
+    // The first 8 bytes value writes, big-endian, with the top bit flipped so
+    // that prefixes order the same way as signed numbers.
+    static int64_t prefixOf(const NodeData& value);
+
+
+    //----------------------------findSlot-------------------------------------
+    // Finds where target, whose prefix is targetPrefix, belongs in a Node.
+    // Sets index to the first key that is not less than target. Returns true
+    // if that key equals target.
+    static bool findSlot(const Node* nodePtr, const NodeData& target
+            , int64_t targetPrefix, int& index);
+
+
+    //----------------------------splitChild-----------------------------------
+    // Splits the full child at index of parentPtr in two and moves its
+    // middle key up into parentPtr, which must not be full.
+    void splitChild(Node* parentPtr, int index);
+
+
+    // Copying a BTree is not supported.
+    BTree(const BTree&);
+    BTree& operator=(const BTree&);
+
+
+public:
+
+    //---------------------------Empty Constructor-----------------------------
+    // Creates an empty BTree.
+    BTree();
+
+
+    // ---------------------------Destructor----------------------------------
+    // Destroys tree and frees memory. Calls makeEmpty().
+    ~BTree();
+
+
+    // ---------------------------isEmpty---------------------------------------
+    // Returns true if empty. Returns false if not.
+    bool isEmpty() const;
+
+
+    //---------------------------makeEmpty-------------------------------------
+    // Deletes every NodeData and makes the BTree empty.
+    void makeEmpty();
+
+
+    //------------------------------insert-------------------------------------
+    // Inserts the NodeData into the BTree, which takes ownership of it.
+    // Returns false, and does not take ownership, if it is already there.
+    bool insert(NodeData* s);
+
+
+    // -------------------------retrieve--------------------------------------
+    // Returns true if NodeData is in BTree and points the second argument at
+    // it. Returns false and sets it to NULL otherwise.
+    bool retrieve(const NodeData &, NodeData *&) const;
+
+
+    // --------------------------getHeight-----------------------------------
+    // Returns the height, in Nodes, of the Node holding the NodeData from the
+    // bottom of the BTree. Returns 0 if it is not in the BTree.
+    int getHeight(const NodeData &) const;
+};
+
+#endif
@@ -0,0 +1,268 @@
+#include "concurrentbintree.h"
+#include <new>
+
+thread_local vector<ConcurrentBinTree::Node*>
+        ConcurrentBinTree::insertPath;
+
+
+/*-----------------------------Empty Constructor-------------------------------
+ * Pre: None
+ *
+ * Post: Creates an empty ConcurrentBinTree.
+ *---------------------------------------------------------------------------*/
+ConcurrentBinTree::ConcurrentBinTree() : root(NULL), pool(sizeof(Node)) {
+}
+
+
+
+/*---------------------------------Destructor----------------------------------
+ * Pre: No other thread is using this tree.
+ *
+ * Post: Deletes every NodeData and frees every Node.
+ *---------------------------------------------------------------------------*/
+ConcurrentBinTree::~ConcurrentBinTree() {
+    makeEmpty();
+}
+
+
+
+/*---------------------------------isEmpty-------------------------------------
+ * Pre: None.
+ *
+ * Post: Returns true if the tree is empty. Returns false if it is not.
+ *---------------------------------------------------------------------------*/
+bool ConcurrentBinTree::isEmpty() const {
+    return root.load(memory_order_acquire) == NULL;
+}
+
+
+
+/* -------------------------------makeEmpty------------------------------------
+ * Pre: No other thread is using this tree.
+ *
+ * Post: Deletes the NodeData in every Node, walking the Nodes with an
+ *       explicit stack, then frees the Nodes a block at a time with the
+ *       pool. The tree becomes empty.
+ *---------------------------------------------------------------------------*/
+void ConcurrentBinTree::makeEmpty() {
+    vector<Node*> stack;
+    stack.push_back(root.load(memory_order_relaxed));
+    while (!stack.empty()) {
+        Node* currentPtr = stack.back();
+        stack.pop_back();
+        if (currentPtr != NULL) {
+            stack.push_back(currentPtr->left.load(memory_order_relaxed));
+            stack.push_back(currentPtr->right.load(memory_order_relaxed));
+            delete currentPtr->data;
+        }
+    }
+    pool.releaseAll();
+    root.store(NULL, memory_order_relaxed);
+}
+
+
+
+/*----------------------------------insert-------------------------------------
+ * Pre: Takes in a pointer to a NodeData, insertPtr, which is the value that
+ *      will be inserted into the tree.
+ *
+ * Post: Descends without locking to the NULL link where insertPtr belongs,
+ *       then tries to swap a new Node into it. If another thread filled the
+ *       link first, keeps descending from the Node it put there, reusing the
+ *       same new Node. Each level does one < comparison and remembers the
+ *       last Node that was not less than insertPtr; only that Node can be
+ *       equal, so it is checked once each time a NULL link is reached. A
+ *       thread inserting an equal value always races for the same link, so
+ *       exactly one of them wins, and the loser then finds the winner as
+ *       its candidate. Losing a race costs one more comparison and one
+ *       more compare-and-swap, a level lower; with monotone or hot keys
+ *       every thread races for the same rightmost link, and the losses add
+ *       up (see the class comment).
+ *
+ *       Once the new Node is in, walks back up the Nodes it went through
+ *       and raises each one's height to at least its distance above the new
+ *       Node, with compare-and-swap. It stops at the first Node that is
+ *       already that tall: whoever made it so raises the Nodes above. Returns
+ *       true if inserted. Returns false if the value is already in the
+ *       tree; the caller still owns insertPtr.
+ *---------------------------------------------------------------------------*/
+bool ConcurrentBinTree::insert(NodeData* insertPtr) {
+    Node* newNodePtr = NULL;
+    Node* candidatePtr = NULL;          // last Node not less than insertPtr
+    atomic<Node*>* linkPtr = &root;
+    Node* currentPtr = linkPtr->load(memory_order_acquire);
+    insertPath.clear();
+    while (true) {
+        if (currentPtr == NULL) {
+            if (candidatePtr != NULL
+                    && !(*insertPtr < *candidatePtr->data)) {
+                if (newNodePtr != NULL) {
+                    lock_guard<mutex> guard(poolLock);
+                    pool.release(newNodePtr);
+                }
+                return false;
+            }
+            if (newNodePtr == NULL) {
+                newNodePtr = newNode(insertPtr);
+            }
+            if (linkPtr->compare_exchange_strong(currentPtr, newNodePtr
+                    , memory_order_release, memory_order_acquire)) {
+                raiseHeights();
+                return true;
+            }
+            // Lost the race, currentPtr is now the Node that won.
+        } else {
+            insertPath.push_back(currentPtr);
+            if (*currentPtr->data < *insertPtr) {
+                linkPtr = &currentPtr->right;
+            } else {
+                candidatePtr = currentPtr;
+                linkPtr = &currentPtr->left;
+            }
+            currentPtr = linkPtr->load(memory_order_acquire);
+        }
+    }
+}
+
+
+
+/*------------------------------Private: newNode-------------------------------
+ * Pre: Takes in a pointer to a NodeData, data.
+ *
+ * Post: Takes a Node from the pool while holding poolLock and returns it as
+ *       a leaf holding data. Nothing else is locked, so only the allocation
+ *       itself is serialized between inserting threads.
+ *---------------------------------------------------------------------------*/
+ConcurrentBinTree::Node* ConcurrentBinTree::newNode(NodeData* data) {
+    Node* nodePtr;
+    {
+        lock_guard<mutex> guard(poolLock);
+        nodePtr = static_cast<Node*>(pool.allocate());
+    }
+    nodePtr->data = data;
+    new (&nodePtr->left) atomic<Node*>(NULL);
+    new (&nodePtr->right) atomic<Node*>(NULL);
+    new (&nodePtr->height) atomic<int>(1);
+    return nodePtr;
+}
+
+
+
+/*----------------------------Private: raiseHeights----------------------------
+ * Pre: insertPath holds the Nodes this thread's insert() went through, from
+ *      the root down, and the new Node now hangs from the last one.
+ *
+ * Post: Goes up insertPath, raising each Node's height to one more than
+ *       the height the Node below it needs, until a Node is already at
+ *       least that tall. Heights only ever grow, so a failed
+ *       compare-and-swap just means another insert raised it first.
+ *---------------------------------------------------------------------------*/
+void ConcurrentBinTree::raiseHeights() {
+    int height = 1;                     // the new Node's
+    for (size_t i = insertPath.size(); i > 0; i--) {
+        height++;
+        atomic<int>& heightRef = insertPath[i - 1]->height;
+        int seen = heightRef.load(memory_order_relaxed);
+        if (seen >= height) {
+            return;
+        }
+        while (seen < height && !heightRef.compare_exchange_weak(seen
+                , height, memory_order_release, memory_order_relaxed)) {
+        }
+    }
+}
+
+
+
+/*------------------------------Private: findNode------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target.
+ *
+ * Post: Descends from the root one side per comparison, loading each link
+ *       with acquire so that any Node reached is fully built. Like insert,
+ *       checks for equality only once, at the bottom. Returns the Node that
+ *       holds target, or NULL if it is not in the tree.
+ *---------------------------------------------------------------------------*/
+const ConcurrentBinTree::Node* ConcurrentBinTree::findNode(
+        const NodeData& target) const {
+    const Node* currentPtr = root.load(memory_order_acquire);
+    const Node* candidatePtr = NULL;
+    while (currentPtr != NULL) {
+        if (*currentPtr->data < target) {
+            currentPtr = currentPtr->right.load(memory_order_acquire);
+        } else {
+            candidatePtr = currentPtr;
+            currentPtr = currentPtr->left.load(memory_order_acquire);
+        }
+    }
+    if (candidatePtr != NULL && !(target < *candidatePtr->data)) {
+        return candidatePtr;
+    }
+    return NULL;
+}
+
+
+
+/*-------------------------------retrieve-------------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target, which is the
+ *      value to look for. Takes in a pointer reference to a NodeData,
+ *      nodeDataPtr.
+ *
+ * Post: Without locking, makes nodeDataPtr point to the NodeData equal to
+ *       target and returns true. If target is not in the tree, sets
+ *       nodeDataPtr to NULL and returns false. An insert that finished
+ *       before retrieve() started is always seen.
+ *---------------------------------------------------------------------------*/
+bool ConcurrentBinTree::retrieve(const NodeData& target
+        , NodeData*& nodeDataPtr) const {
+    const Node* nodePtr = findNode(target);
+    if (nodePtr != NULL) {
+        nodeDataPtr = nodePtr->data;
+        return true;
+    }
+    nodeDataPtr = NULL;
+    return false;
+}
+
+
+
+/*--------------------------------getHeight------------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target.
+ *
+ * Post: Without locking, finds target and returns the height its Node
+ *       keeps, counted from the bottom of the tree. An insert below it that
+ *       has not finished raising heights may or may not be counted. Returns
+ *       0 if target is not found.
+ *---------------------------------------------------------------------------*/
+int ConcurrentBinTree::getHeight(const NodeData& target) const {
+    const Node* nodePtr = findNode(target);
+    return nodePtr != NULL ? nodePtr->height.load(memory_order_acquire) : 0;
+}
+
+
+
+/* -----------------------------Output Operator--------------------------------
+ * Pre: Takes in a reference to an ostream, outStream. Takes in a read-only
+ *      reference to a ConcurrentBinTree, otherTree.
+ *
+ * Post: Writes every NodeData to outStream in order, without locking.
+ *       Everything that was in the tree when the output started is written,
+ *       in sorted order; Nodes inserted during the output may or may not
+ *       be. Returns outStream.
+ *---------------------------------------------------------------------------*/
+ostream& operator<<(ostream& outStream, const ConcurrentBinTree& otherTree) {
+    typedef ConcurrentBinTree::Node Node;
+    vector<const Node*> stack;
+    const Node* currentPtr = otherTree.root.load(memory_order_acquire);
+    while (currentPtr != NULL || !stack.empty()) {
+        while (currentPtr != NULL) {
+            stack.push_back(currentPtr);
+            currentPtr = currentPtr->left.load(memory_order_acquire);
+        }
+        currentPtr = stack.back();
+        stack.pop_back();
+        outStream << *currentPtr->data << " ";
+        currentPtr = currentPtr->right.load(memory_order_acquire);
+    }
+    outStream << endl;
+    return outStream;
+}
@@ -0,0 +1,138 @@
+#ifndef CONCURRENTBINTREE_H
+#define CONCURRENTBINTREE_H
+
+#include "nodedata.h"
+#include "nodepool.h"
+#include <atomic>
+#include <mutex>
+#include <vector>
+
+/* This class, ConcurrentBinTree, is a Binary Search Tree that many threads
+ * can read from and insert into at the same time.
+ *
+ * retrieve(), getHeight() and the output operator take no locks. insert()
+ * does not lock the tree either, so inserts into different parts of the
+ * tree run in parallel and callers do not need a lock of their own.
+ *
+ * A Node never changes once it is in the tree: an insert only fills in a
+ * NULL child link of the Node it hangs from, with a compare-and-swap that
+ * publishes the new Node. If another insert fills that link first, the
+ * loser carries on down from the Node that won, so two inserts of the same
+ * value meet at the same link and the second one returns false, just as
+ * BinTree::insert() does. Readers load links with acquire, so they either
+ * see a new Node completely built or do not see it at all. No Node is freed
+ * while the tree is in use, so readers never need to be tracked.
+ *
+ * Every Node also keeps the height of its subtree, which only grows. An
+ * insert raises the heights on its path with compare-and-swap once its Node
+ * is in, so getHeight() reads one number instead of walking the subtree.
+ *
+ * The tree is never rebalanced: rotating a published Node would change a
+ * link some reader or inserter is following without a lock. Like a BinTree
+ * that is not balanced, it takes the shape of the order its data arrives
+ * in. Random keys give it O(log n) depth, but sorted or nearly sorted
+ * ingest builds one long path, and every insert and lookup on it is O(n).
+ * Shuffle such data before inserting it, or use a balanced BinTree behind
+ * a lock.
+ *
+ * Inserts only contend where they meet. Keys that keep growing (counters,
+ * timestamps) send every producer to the same NULL link, the rightmost one,
+ * and so do a few hot keys that are not in the tree yet. Only one
+ * compare-and-swap on that link succeeds. Each loser steps down to the Node
+ * that won and tries again below it, so with p producers one insert can
+ * fail up to p - 1 times while the Node they all write to moves between
+ * their caches. A failed attempt always means another insert succeeded, so
+ * the tree keeps making progress, but such inserts scale no better than
+ * one thread. Shuffling a batch of them before inserting spreads them out.
+ *
+ * makeEmpty() and the destructor are the exception: no other thread may be
+ * using the tree while they run.
+ * */
+class ConcurrentBinTree {
+
+friend ostream& operator<<(ostream& outStream
+        , const ConcurrentBinTree& otherTree);
+
+
+private:
+    struct Node {
+        NodeData* data;                     // never changes once published
+        atomic<Node*> left;                 // left subtree pointer
+        atomic<Node*> right;                // right subtree pointer
+        atomic<int> height;                 // height of this subtree
+    };
+    atomic<Node*> root;                     // root of the tree
+    NodePool pool;                          // memory for every Node
+    mutex poolLock;                         // guards pool, not the tree
+
+    // The Nodes this thread's last insert() went through, reused by every
+    // insert on the thread.
+    static thread_local vector<Node*> insertPath;
+
+
+    //---------------------------newNode---------------------------------------
+    // Takes a Node from the pool, under poolLock, and makes it a leaf
+    // holding data.
+    Node* newNode(NodeData* data);
+
+
+    //---------------------------raiseHeights----------------------------------
+    // Raises the heights on insertPath after a new Node has been hung from
+    // its last Node, stopping where they are already high enough.
+    static void raiseHeights();
+
+
+    //---------------------------findNode--------------------------------------
+    // Finds the Node holding target without taking any lock. Returns NULL
+    // if it is not in the tree.
+    const Node* findNode(const NodeData& target) const;
+
+
+    // Copying a ConcurrentBinTree is not supported.
+    ConcurrentBinTree(const ConcurrentBinTree&);
+    ConcurrentBinTree& operator=(const ConcurrentBinTree&);
+
+
+public:
+
+    //---------------------------Empty Constructor-----------------------------
+    // Creates an empty ConcurrentBinTree.
+    ConcurrentBinTree();
+
+
+    // ---------------------------Destructor----------------------------------
+    // Destroys tree and frees memory. No other thread may be using it.
+    ~ConcurrentBinTree();
+
+
+    // ---------------------------isEmpty---------------------------------------
+    // Returns true if empty. Returns false if not.
+    bool isEmpty() const;
+
+
+    //---------------------------makeEmpty-------------------------------------
+    // Deletes every NodeData and makes the tree empty. No other thread may be
+    // using the tree while it runs.
+    void makeEmpty();
+
+
+    //------------------------------insert-------------------------------------
+    // Inserts the NodeData, which the tree then owns. Returns false, and does
+    // not take ownership, if its value is already in the tree. Safe to call
+    // while other threads read or insert.
+    bool insert(NodeData* s);
+
+
+    // -------------------------retrieve--------------------------------------
+    // Returns true if NodeData is in the tree and points the second argument
+    // at it. Returns false and sets it to NULL otherwise. Lock-free.
+    bool retrieve(const NodeData &, NodeData *&) const;
+
+
+    // --------------------------getHeight-----------------------------------
+    // Returns the height of the Node holding NodeData from the bottom of the
+    // tree, or 0 if it is not there. Lock-free and O(depth).
+    int getHeight(const NodeData &) const;
+};
+
+#endif
@@ -0,0 +1,154 @@
+#include "frozentree.h"
+
+// How many levels ahead lowerBound() prefetches. The 2^3 positions three
+// levels below position k are next to each other, starting at 8k.
+static const size_t PREFETCH_LEVELS = 3;
+
+
+/*-----------------------------Static: fillOrder-------------------------------
+ * Pre: Takes in a vector of ints, order, sized for size + 1 positions. Takes
+ *      in a size_t, position, which is the Eytzinger position to fill. Takes
+ *      in a reference to an int, next, which is the next sorted index.
+ *
+ * Post: Walks the implicit tree at position in order, so order[k] ends up
+ *       holding the sorted index that belongs at position k. Only recurses
+ *       O(log n) deep because the implicit tree is complete.
+ *---------------------------------------------------------------------------*/
+static void fillOrder(vector<int>& order, size_t position, int& next) {
+    if (position < order.size()) {
+        fillOrder(order, 2 * position, next);
+        order[position] = next;
+        next++;
+        fillOrder(order, 2 * position + 1, next);
+    }
+}
+
+
+
+/*-----------------------------Empty Constructor-------------------------------
+ * Pre: None
+ *
+ * Post: Creates an empty FrozenTree.
+ *---------------------------------------------------------------------------*/
+FrozenTree::FrozenTree() {
+}
+
+
+
+/*-----------------------------Array Constructor-------------------------------
+ * Pre: Takes in an array of read-only NodeData pointers, sorted, whose first
+ *      size entries are strictly increasing. Takes in an int, size.
+ *
+ * Post: Copies every NodeData into keys in Eytzinger order. sorted and the
+ *       NodeData it points to are unchanged.
+ *---------------------------------------------------------------------------*/
+FrozenTree::FrozenTree(const NodeData* const sorted[], int size) {
+    if (size <= 0) {
+        return;
+    }
+    vector<int> order(size + 1);
+    int next = 0;
+    fillOrder(order, 1, next);
+    keys.reserve(size);
+    for (int k = 1; k <= size; k++) {
+        keys.push_back(*sorted[order[k]]);
+    }
+}
+
+
+
+/*---------------------------------isEmpty-------------------------------------
+ * Pre: None.
+ *
+ * Post: Returns true if the FrozenTree has no NodeData. Returns false if it
+ *       does.
+ *---------------------------------------------------------------------------*/
+bool FrozenTree::isEmpty() const {
+    return keys.empty();
+}
+
+
+
+/*----------------------------------size---------------------------------------
+ * Pre: None.
+ *
+ * Post: Returns the number of NodeData in the FrozenTree.
+ *---------------------------------------------------------------------------*/
+int FrozenTree::size() const {
+    return static_cast<int>(keys.size());
+}
+
+
+
+/*---------------------------Private: lowerBound-------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target.
+ *
+ * Post: Descends from the root, going right when the key is less than
+ *       target and left otherwise, until it falls off the bottom. The result
+ *       of each comparison only picks the next position, so there is no
+ *       branch to mispredict. The position of the last left turn is the
+ *       first key that is not less than target, and is found by dropping
+ *       the trailing right turns (1 bits) and that left turn. Returns 0 if
+ *       the search never turned left.
+ *---------------------------------------------------------------------------*/
+size_t FrozenTree::lowerBound(const NodeData& target) const {
+    const size_t count = keys.size();
+    const NodeData* keyPtr = keys.data();       // keyPtr[k - 1] is position k
+    size_t k = 1;
+    while (k <= count) {
+#if defined(__GNUC__)
+        if ((k << PREFETCH_LEVELS) <= count) {
+            __builtin_prefetch(keyPtr + (k << PREFETCH_LEVELS) - 1);
+        }
+#endif
+        k = 2 * k + (keyPtr[k - 1] < target);
+    }
+    while ((k & 1) != 0) {
+        k >>= 1;
+    }
+    return k >> 1;
+}
+
+
+
+/*-------------------------------retrieve-------------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target, which is the
+ *      value to look for. Takes in a pointer reference to a read-only
+ *      NodeData, nodeDataPtr.
+ *
+ * Post: Makes nodeDataPtr point to the copy of target's value in the
+ *       FrozenTree and returns true. If target is not in the FrozenTree,
+ *       sets nodeDataPtr to NULL and returns false.
+ *---------------------------------------------------------------------------*/
+bool FrozenTree::retrieve(const NodeData& target
+        , const NodeData*& nodeDataPtr) const {
+    size_t k = lowerBound(target);
+    if (k != 0 && !(target < keys[k - 1])) {
+        nodeDataPtr = &keys[k - 1];
+        return true;
+    }
+    nodeDataPtr = NULL;
+    return false;
+}
+
+
+
+/*--------------------------------getHeight------------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target.
+ *
+ * Post: Returns the height of target's position from the bottom of the
+ *       FrozenTree. The implicit tree is complete, so the leftmost path
+ *       below a position is always the longest one and is counted without
+ *       touching any key. Returns 0 if target is not in the FrozenTree.
+ *---------------------------------------------------------------------------*/
+int FrozenTree::getHeight(const NodeData& target) const {
+    const NodeData* nodeDataPtr;
+    if (!retrieve(target, nodeDataPtr)) {
+        return 0;
+    }
+    int height = 0;
+    for (size_t k = nodeDataPtr - keys.data() + 1; k <= keys.size(); k *= 2) {
+        height++;
+    }
+    return height;
+}
@@ -0,0 +1,66 @@
+#ifndef FROZENTREE_H
+#define FROZENTREE_H
+
+#include "nodedata.h"
+#include <vector>
+
+/* This class, FrozenTree, is a read-only copy of a BinTree that is laid out
+ * for fast lookups. It is made with BinTree::freeze().
+ *
+ * The NodeData are copied by value into one array in Eytzinger (breadth
+ * first) order: the root is at position 1 and the children of position k
+ * are at 2k and 2k + 1. There are no Node pointers to follow, each level of
+ * a search is one comparison with no branch on its result, and the levels
+ * a search will reach next are prefetched while the current one is compared.
+ *
+ * The shape is always the complete binary tree over the data, so heights
+ * returned by getHeight() can differ from the BinTree it was frozen from.
+ * */
+class FrozenTree {
+
+private:
+    vector<NodeData> keys;                  // keys[k - 1] is position k
+
+
+    //---------------------------lowerBound------------------------------------
+    // Returns the position of the first key that is not less than target,
+    // or 0 if every key is less than target.
+    size_t lowerBound(const NodeData& target) const;
+
+
+public:
+
+    //---------------------------Empty Constructor-----------------------------
+    // Creates an empty FrozenTree.
+    FrozenTree();
+
+
+    //---------------------------Array Constructor-----------------------------
+    // Copies sorted[0] to sorted[size - 1], which must be strictly increasing,
+    // into a new FrozenTree. The array is left unchanged.
+    FrozenTree(const NodeData* const sorted[], int size);
+
+
+    // ---------------------------isEmpty---------------------------------------
+    // Returns true if empty. Returns false if not.
+    bool isEmpty() const;
+
+
+    // ---------------------------size------------------------------------------
+    // Returns the number of NodeData in the FrozenTree.
+    int size() const;
+
+
+    // -------------------------retrieve--------------------------------------
+    // Returns true if NodeData is in the FrozenTree and points the second
+    // argument at it. Returns false and sets it to NULL otherwise.
+    bool retrieve(const NodeData &, const NodeData *&) const;
+
+
+    // --------------------------getHeight-----------------------------------
+    // Returns the height of the NodeData from the bottom of the FrozenTree.
+    // Returns 0 if it is not in the FrozenTree.
+    int getHeight(const NodeData &) const;
+};
+
+#endif
@@ -0,0 +1,264 @@
+#include "mappedtree.h"
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+const char MappedTree::MAGIC[4] = {'B', 'T', 'R', '1'};
+const uint32_t MappedTree::VERSION;
+const size_t MappedTree::HEADER_SIZE;
+const size_t MappedTree::TRAILER_SIZE;
+
+
+/*-----------------------------Empty Constructor-------------------------------
+ * Pre: None
+ *
+ * Post: Creates a MappedTree with no file open.
+ *---------------------------------------------------------------------------*/
+MappedTree::MappedTree() {
+    mapping = NULL;
+    mappingSize = 0;
+    count = 0;
+    offsetTable = NULL;
+}
+
+
+
+/*---------------------------------Destructor----------------------------------
+ * Pre: None
+ *
+ * Post: Unmaps the file if one is open.
+ *---------------------------------------------------------------------------*/
+MappedTree::~MappedTree() {
+    close();
+}
+
+
+
+/*-----------------------------------open--------------------------------------
+ * Pre: Takes in a read-only C string, path, naming a file written by
+ *      BinTree::writeBinary().
+ *
+ * Post: Closes any file already open, then maps the file at path read-only.
+ *       Checks the magic, version and that the offset table and trailer fit
+ *       the file exactly. Then walks the offset table once: the records
+ *       must start right after the header, follow each other with no gap
+ *       and end where the offset table starts. That reads every record's
+ *       length but none of its bytes, and means no later lookup can read
+ *       outside the records. Returns true if the file is open. Returns
+ *       false, with no file open, if it cannot be opened or mapped or is
+ *       not in the expected format.
+ *---------------------------------------------------------------------------*/
+bool MappedTree::open(const char* path) {
+    close();
+    int fd = ::open(path, O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat fileInfo;
+    if (fstat(fd, &fileInfo) != 0
+            || static_cast<uint64_t>(fileInfo.st_size)
+                    < HEADER_SIZE + TRAILER_SIZE) {
+        ::close(fd);
+        return false;
+    }
+    size_t fileSize = static_cast<size_t>(fileInfo.st_size);
+    void* address = mmap(NULL, fileSize, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);                        // the mapping keeps the file open
+    if (address == MAP_FAILED) {
+        return false;
+    }
+    mapping = static_cast<const char*>(address);
+    mappingSize = fileSize;
+
+    uint64_t fileCount = getUint64(mapping + 8);
+    uint64_t tableOffset = getUint64(mapping + fileSize - TRAILER_SIZE);
+    bool valid = mapping[0] == MAGIC[0] && mapping[1] == MAGIC[1]
+            && mapping[2] == MAGIC[2] && mapping[3] == MAGIC[3]
+            && getUint32(mapping + 4) == VERSION
+            && tableOffset >= HEADER_SIZE
+            && tableOffset <= fileSize - TRAILER_SIZE
+            && (fileSize - TRAILER_SIZE - tableOffset) / 8 == fileCount
+            && (fileSize - TRAILER_SIZE - tableOffset) % 8 == 0;
+
+    // Every test below is written without adding to an offset read from
+    // the file, so a huge offset or length cannot wrap around and pass.
+    uint64_t expected = HEADER_SIZE;            // where the next record starts
+    for (uint64_t i = 0; valid && i < fileCount; i++) {
+        uint64_t offset = getUint64(mapping + tableOffset + i * 8);
+        valid = offset == expected && offset <= tableOffset - 4;
+        if (valid) {
+            uint32_t length = getUint32(mapping + offset);
+            valid = length <= tableOffset - 4 - offset;
+            expected = offset + 4 + length;     // at most tableOffset
+        }
+    }
+    valid = valid && expected == tableOffset;
+    if (!valid) {
+        close();
+        return false;
+    }
+    count = fileCount;
+    offsetTable = mapping + tableOffset;
+    madvise(address, fileSize, MADV_RANDOM);
+    return true;
+}
+
+
+
+/*-----------------------------------close-------------------------------------
+ * Pre: None.
+ *
+ * Post: Unmaps the file if one is open. Any NodeData copied out by
+ *       retrieve() stays valid.
+ *---------------------------------------------------------------------------*/
+void MappedTree::close() {
+    if (mapping != NULL) {
+        munmap(const_cast<char*>(mapping), mappingSize);
+    }
+    mapping = NULL;
+    mappingSize = 0;
+    count = 0;
+    offsetTable = NULL;
+}
+
+
+
+/*---------------------------------isEmpty-------------------------------------
+ * Pre: None.
+ *
+ * Post: Returns true if no file is open or the file has no NodeData.
+ *---------------------------------------------------------------------------*/
+bool MappedTree::isEmpty() const {
+    return count == 0;
+}
+
+
+
+/*----------------------------------size---------------------------------------
+ * Pre: None.
+ *
+ * Post: Returns the number of NodeData in the open file, or 0.
+ *---------------------------------------------------------------------------*/
+uint64_t MappedTree::size() const {
+    return count;
+}
+
+
+
+/*-------------------------------retrieve-------------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target, which is the
+ *      value to look for. Takes in a reference to a NodeData, result.
+ *
+ * Post: Writes target's text once, then binary searches the sorted records
+ *       through the offset table, comparing that text with each record's
+ *       bytes where they lie in the mapping. Only the O(log n) records
+ *       probed are read from the file and none is copied until one matches.
+ *       If target is found, builds result from its record and returns
+ *       true. Returns false and leaves result unchanged otherwise.
+ *---------------------------------------------------------------------------*/
+bool MappedTree::retrieve(const NodeData& target, NodeData& result) const {
+    ostringstream probeStream;
+    probeStream << target;
+    const string probe = probeStream.str();
+
+    uint64_t low = 0;
+    uint64_t high = count;
+    while (low < high) {
+        uint64_t middle = low + (high - low) / 2;
+        uint32_t length;
+        const char* bytes = recordAt(middle, length);
+        int order = memcmp(bytes, probe.data(), min<size_t>(length
+                , probe.size()));
+        if (order == 0 && length != probe.size()) {
+            order = length < probe.size() ? -1 : 1;
+        }
+        if (order == 0) {
+            result = NodeData(string(bytes, length));
+            return true;
+        } else if (order < 0) {
+            low = middle + 1;
+        } else {
+            high = middle;
+        }
+    }
+    return false;
+}
+
+
+
+/*-----------------------------Private: recordAt-------------------------------
+ * Pre: Takes in an index less than count. Takes in a reference to a
+ *      uint32_t, length. open() has checked that every record lies between
+ *      the header and the offset table.
+ *
+ * Post: Looks up record index in the offset table, sets length to the
+ *       number of bytes in it and returns where those bytes start in the
+ *       mapping. Nothing is copied.
+ *---------------------------------------------------------------------------*/
+const char* MappedTree::recordAt(uint64_t index, uint32_t& length) const {
+    uint64_t offset = getUint64(offsetTable + index * 8);
+    length = getUint32(mapping + offset);
+    return mapping + offset + 4;
+}
+
+
+
+/*---------------------------------putUint32-----------------------------------
+ * Pre: Takes in a pointer, bytes, to at least 4 writable bytes. Takes in a
+ *      uint32_t, value.
+ *
+ * Post: Writes value to bytes lowest byte first.
+ *---------------------------------------------------------------------------*/
+void MappedTree::putUint32(char* bytes, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        bytes[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+
+
+/*---------------------------------putUint64-----------------------------------
+ * Pre: Takes in a pointer, bytes, to at least 8 writable bytes. Takes in a
+ *      uint64_t, value.
+ *
+ * Post: Writes value to bytes lowest byte first.
+ *---------------------------------------------------------------------------*/
+void MappedTree::putUint64(char* bytes, uint64_t value) {
+    for (int i = 0; i < 8; i++) {
+        bytes[i] = static_cast<char>((value >> (8 * i)) & 0xff);
+    }
+}
+
+
+
+/*---------------------------------getUint32-----------------------------------
+ * Pre: Takes in a read-only pointer, bytes, to at least 4 bytes.
+ *
+ * Post: Returns the little-endian value stored at bytes.
+ *---------------------------------------------------------------------------*/
+uint32_t MappedTree::getUint32(const char* bytes) {
+    uint32_t value = 0;
+    for (int i = 3; i >= 0; i--) {
+        value = (value << 8) | static_cast<unsigned char>(bytes[i]);
+    }
+    return value;
+}
+
+
+
+/*---------------------------------getUint64-----------------------------------
+ * Pre: Takes in a read-only pointer, bytes, to at least 8 bytes.
+ *
+ * Post: Returns the little-endian value stored at bytes.
+ *---------------------------------------------------------------------------*/
+uint64_t MappedTree::getUint64(const char* bytes) {
+    uint64_t value = 0;
+    for (int i = 7; i >= 0; i--) {
+        value = (value << 8) | static_cast<unsigned char>(bytes[i]);
+    }
+    return value;
+}
@@ -0,0 +1,109 @@
+#ifndef MAPPEDTREE_H
+#define MAPPEDTREE_H
+
+#include "nodedata.h"
+#include <cstddef>
+#include <stdint.h>
+
+/* This class, MappedTree, answers lookups straight from a file written by
+ * BinTree::writeBinary(), without reading the file in first. The file is
+ * memory mapped. Opening it reads only the offset table and each record's
+ * length, to check the file, and a lookup reads only the records it
+ * probes. No record is copied into memory until a lookup finds it.
+ *
+ * File format (every integer is little-endian):
+ *
+ *      "BTR1"                  4 bytes
+ *      version                 uint32, currently 1
+ *      count                   uint64, number of NodeData
+ *      count records, sorted   uint32 length, then length bytes
+ *      offset table            count uint64, file offset of each record
+ *      table offset            uint64, file offset of the offset table
+ *
+ * A record holds the text that NodeData's output operator writes, and is
+ * turned back into a NodeData with NodeData's string constructor. A reader
+ * that only streams the file can stop after the records.
+ *
+ * Lookups compare that text byte by byte, the way string compares, without
+ * building a NodeData for each record. That matches NodeData's own order
+ * because a NodeData compares as the string it writes.
+ * */
+class MappedTree {
+
+public:
+    static const char MAGIC[4];                 // first 4 bytes of a file
+    static const uint32_t VERSION = 1;          // format written today
+    static const size_t HEADER_SIZE = 16;       // magic, version, count
+    static const size_t TRAILER_SIZE = 8;       // table offset
+
+
+    //---------------------------putUint32 / putUint64-------------------------
+    // Write value as 4 or 8 little-endian bytes starting at bytes.
+    static void putUint32(char* bytes, uint32_t value);
+    static void putUint64(char* bytes, uint64_t value);
+
+
+    //---------------------------getUint32 / getUint64-------------------------
+    // Read 4 or 8 little-endian bytes starting at bytes.
+    static uint32_t getUint32(const char* bytes);
+    static uint64_t getUint64(const char* bytes);
+
+
+private:
+    const char* mapping;                    // the whole file, or NULL
+    size_t mappingSize;                     // bytes mapped
+    uint64_t count;                         // NodeData in the file
+    const char* offsetTable;                // count offsets into mapping
+
+
+    //---------------------------recordAt--------------------------------------
+    // Returns where the bytes of record index start, and how many there are.
+    const char* recordAt(uint64_t index, uint32_t& length) const;
+
+
+    // Copying a MappedTree would unmap the same file twice.
+    MappedTree(const MappedTree&);
+    MappedTree& operator=(const MappedTree&);
+
+
+public:
+
+    //---------------------------Empty Constructor-----------------------------
+    // Creates a MappedTree with no file open.
+    MappedTree();
+
+
+    // ---------------------------Destructor----------------------------------
+    // Unmaps the file if one is open. Calls close().
+    ~MappedTree();
+
+
+    //---------------------------open------------------------------------------
+    // Maps the file at path and checks that every record fits. Returns
+    // false, with no file open, if it cannot be mapped or is not a valid
+    // file.
+    bool open(const char* path);
+
+
+    //---------------------------close-----------------------------------------
+    // Unmaps the file. The MappedTree is empty afterwards.
+    void close();
+
+
+    // ---------------------------isEmpty---------------------------------------
+    // Returns true if no file is open or it holds no NodeData.
+    bool isEmpty() const;
+
+
+    // ---------------------------size------------------------------------------
+    // Returns the number of NodeData in the file.
+    uint64_t size() const;
+
+
+    // -------------------------retrieve--------------------------------------
+    // Returns true if NodeData is in the file and copies it into the second
+    // argument. Returns false otherwise.
+    bool retrieve(const NodeData &, NodeData &) const;
+};
+
+#endif
@@ -0,0 +1,186 @@
+#include "nodepool.h"
+#include <new>
+#include <stdint.h>
+#include <utility>
+
+// Blocks start small so that small trees stay small, and stop doubling once
+// a block is large enough that the heap call is lost in the cost of filling
+// it.
+static const size_t FIRST_BLOCK_SLOTS = 64;
+static const size_t MAX_BLOCK_SLOTS = 8192;
+
+
+/*---------------------------------Constructor---------------------------------
+ * Pre: Takes in a size_t, slotSize, which is the size of the objects that
+ *      will be stored in the pool. Takes in a size_t, alignment, which is a
+ *      power of two.
+ *
+ * Post: Creates an empty pool. No memory is allocated until the first call
+ *       to allocate(). Slots are rounded up to a multiple of alignment, and
+ *       of what any type needs, so that every slot is aligned to both.
+ *---------------------------------------------------------------------------*/
+NodePool::NodePool(size_t slotSize, size_t alignment) noexcept {
+    const size_t minimum = sizeof(void*) * 2;
+    if (alignment < minimum) {
+        alignment = minimum;
+    }
+    if (slotSize < sizeof(FreeSlot)) {
+        slotSize = sizeof(FreeSlot);
+    }
+    this->slotSize = (slotSize + alignment - 1) / alignment * alignment;
+    this->alignment = alignment;
+    blocks = NULL;
+    freeList = NULL;
+    nextSlot = NULL;
+    blockEnd = NULL;
+    blockSlots = FIRST_BLOCK_SLOTS;
+}
+
+
+
+/*---------------------------------Destructor----------------------------------
+ * Pre: None.
+ *
+ * Post: Frees every block owned by the pool.
+ *---------------------------------------------------------------------------*/
+NodePool::~NodePool() {
+    releaseAll();
+}
+
+
+
+/*----------------------------------allocate-----------------------------------
+ * Pre: None.
+ *
+ * Post: Returns a pointer to an uninitialized slot of slotSize bytes. Slots
+ *       on the free list are reused first. Otherwise the slot is carved from
+ *       the newest block, and a new block is added when it is full.
+ *---------------------------------------------------------------------------*/
+void* NodePool::allocate() {
+    if (freeList != NULL) {
+        FreeSlot* slotPtr = freeList;
+        freeList = freeList->next;
+        return slotPtr;
+    }
+    if (nextSlot == blockEnd) {
+        addBlock();
+    }
+    void* slotPtr = nextSlot;
+    nextSlot += slotSize;
+    return slotPtr;
+}
+
+
+
+/*-----------------------------------release-----------------------------------
+ * Pre: Takes in a pointer, slotPtr, that was returned by allocate() on this
+ *      pool and has not been released since.
+ *
+ * Post: Puts slotPtr onto the free list so the next allocate() reuses it.
+ *---------------------------------------------------------------------------*/
+void NodePool::release(void* slotPtr) {
+    FreeSlot* freePtr = static_cast<FreeSlot*>(slotPtr);
+    freePtr->next = freeList;
+    freeList = freePtr;
+}
+
+
+
+/*---------------------------------releaseAll----------------------------------
+ * Pre: None.
+ *
+ * Post: Frees every block at once without visiting the slots. Every pointer
+ *       handed out by allocate() is invalid afterwards. The pool can still
+ *       be used and starts over with a small block.
+ *---------------------------------------------------------------------------*/
+void NodePool::releaseAll() {
+    while (blocks != NULL) {
+        Block* nextPtr = blocks->next;
+        ::operator delete(blocks);
+        blocks = nextPtr;
+    }
+    freeList = NULL;
+    nextSlot = NULL;
+    blockEnd = NULL;
+    blockSlots = FIRST_BLOCK_SLOTS;
+}
+
+
+
+/*-----------------------------------splice------------------------------------
+ * Pre: Takes in a reference to another NodePool, otherPool, that hands out
+ *      slots of the same size and alignment.
+ *
+ * Post: Moves every block of otherPool onto this pool's list of blocks and
+ *       its free list onto this pool's free list, so the slots otherPool
+ *       handed out are freed with this pool from now on. Space otherPool
+ *       had not carved up yet is not reused. otherPool is left empty.
+ *---------------------------------------------------------------------------*/
+void NodePool::splice(NodePool& otherPool) {
+    if (otherPool.blocks == NULL) {
+        return;
+    }
+    Block* lastPtr = otherPool.blocks;
+    while (lastPtr->next != NULL) {
+        lastPtr = lastPtr->next;
+    }
+    lastPtr->next = blocks;
+    blocks = otherPool.blocks;
+
+    while (otherPool.freeList != NULL) {
+        FreeSlot* slotPtr = otherPool.freeList;
+        otherPool.freeList = slotPtr->next;
+        release(slotPtr);
+    }
+    otherPool.blocks = NULL;
+    otherPool.nextSlot = NULL;
+    otherPool.blockEnd = NULL;
+    otherPool.blockSlots = FIRST_BLOCK_SLOTS;
+}
+
+
+
+/*------------------------------------swap-------------------------------------
+ * Pre: Takes in a reference to another NodePool, otherPool, that hands out
+ *      slots of the same size and alignment.
+ *
+ * Post: Exchanges the blocks, free list and sizes of the two pools, so the
+ *       slots each one handed out now belong to the other.
+ *---------------------------------------------------------------------------*/
+void NodePool::swap(NodePool& otherPool) noexcept {
+    std::swap(blocks, otherPool.blocks);
+    std::swap(freeList, otherPool.freeList);
+    std::swap(nextSlot, otherPool.nextSlot);
+    std::swap(blockEnd, otherPool.blockEnd);
+    std::swap(slotSize, otherPool.slotSize);
+    std::swap(alignment, otherPool.alignment);
+    std::swap(blockSlots, otherPool.blockSlots);
+}
+
+
+
+/*----------------------------Private: addBlock--------------------------------
+ * Pre: None.
+ *
+ * Post: Allocates a block big enough for blockSlots slots plus the block
+ *       header and makes it the block that allocate() carves from. The
+ *       heap only promises the default alignment, so a pool with a larger
+ *       one asks for that much more and skips up to the first aligned
+ *       address. The next block will be twice as big, up to MAX_BLOCK_SLOTS.
+ *---------------------------------------------------------------------------*/
+void NodePool::addBlock() {
+    size_t headerSize = (sizeof(Block) + slotSize - 1) / slotSize * slotSize;
+    size_t slack = alignment - sizeof(void*) * 2;
+    char* memory = static_cast<char*>(
+            ::operator new(headerSize + slack + blockSlots * slotSize));
+    Block* blockPtr = reinterpret_cast<Block*>(memory);
+    blockPtr->next = blocks;
+    blocks = blockPtr;
+    uintptr_t first = reinterpret_cast<uintptr_t>(memory) + headerSize;
+    size_t skip = (alignment - first % alignment) % alignment;  // <= slack
+    nextSlot = memory + headerSize + skip;
+    blockEnd = nextSlot + blockSlots * slotSize;
+    if (blockSlots < MAX_BLOCK_SLOTS) {
+        blockSlots *= 2;
+    }
+}
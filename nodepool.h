@@ -0,0 +1,87 @@
+#ifndef NODEPOOL_H
+#define NODEPOOL_H
+
+#include <cstddef>
+
+/* This class, NodePool, hands out fixed size slots of memory that are carved
+ * from large contiguous blocks instead of asking the heap for every Node.
+ *
+ * Released slots go onto a free list and are reused by the next allocate().
+ * All of the slots can be given back at once with releaseAll(), which only
+ * frees the blocks, so the cost depends on the number of blocks and not on
+ * the number of slots handed out. Blocks double in size as the pool grows,
+ * up to a fixed maximum.
+ *
+ * NodePool only deals with raw memory. The owner constructs its objects in
+ * the slots and must not rely on any destructor being run by the pool.
+ * */
+class NodePool {
+
+private:
+    struct FreeSlot {
+        FreeSlot* next;                     // next free slot
+    };
+    struct Block {
+        Block* next;                        // next block owned by the pool
+    };
+    Block* blocks;                          // every block owned by the pool
+    FreeSlot* freeList;                     // slots released for reuse
+    char* nextSlot;                         // next unused slot in blocks
+    char* blockEnd;                         // end of the newest block
+    size_t slotSize;                        // bytes per slot, aligned
+    size_t alignment;                       // every slot starts at a multiple
+    size_t blockSlots;                      // slots in the next block
+
+
+    //---------------------------addBlock--------------------------------------
+    // Allocates a new block for allocate() to carve slots from.
+    void addBlock();
+
+
+    // Copying a NodePool would free the same blocks twice.
+    NodePool(const NodePool&);
+    NodePool& operator=(const NodePool&);
+
+
+public:
+
+    //---------------------------Constructor-----------------------------------
+    // Creates an empty pool that hands out slots of at least slotSize bytes,
+    // each aligned to alignment, a power of two (by default enough for any
+    // type). Allocates nothing, so it never throws.
+    explicit NodePool(size_t slotSize, size_t alignment = 2 * sizeof(void*))
+            noexcept;
+
+
+    // ---------------------------Destructor----------------------------------
+    // Frees every block. Calls releaseAll().
+    ~NodePool();
+
+
+    //---------------------------allocate--------------------------------------
+    // Returns an uninitialized slot. Reuses a released slot if there is one.
+    void* allocate();
+
+
+    //---------------------------release---------------------------------------
+    // Puts a slot that came from allocate() onto the free list.
+    void release(void* slotPtr);
+
+
+    //---------------------------releaseAll------------------------------------
+    // Frees every block at once. Every slot handed out becomes invalid.
+    void releaseAll();
+
+
+    //---------------------------splice----------------------------------------
+    // Takes over every block of otherPool, which is left empty. Slots handed
+    // out by otherPool stay valid and now belong to this pool.
+    void splice(NodePool& otherPool);
+
+
+    //---------------------------swap------------------------------------------
+    // Exchanges every block and slot with otherPool in O(1).
+    void swap(NodePool& otherPool) noexcept;
+};
+
+#endif
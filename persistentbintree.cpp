@@ -0,0 +1,433 @@
+#include "persistentbintree.h"
+#include <vector>
+
+
+/*-----------------------------Empty Constructor-------------------------------
+ * Pre: None
+ *
+ * Post: Creates an empty PersistentBinTree.
+ *---------------------------------------------------------------------------*/
+PersistentBinTree::PersistentBinTree() {
+    root = NULL;
+}
+
+
+
+/* ------------------------------Copy Constructor------------------------------
+ * Pre: Takes in a read-only reference to another PersistentBinTree,
+ *      otherTree.
+ *
+ * Post: Shares otherTree's root, and with it every Node, by adding one
+ *       reference to it. Nothing is copied.
+ *---------------------------------------------------------------------------*/
+PersistentBinTree::PersistentBinTree(const PersistentBinTree& otherTree) {
+    root = retain(otherTree.root);
+}
+
+
+
+/*---------------------------------Destructor----------------------------------
+ * Pre: None.
+ *
+ * Post: Gives back this version's reference to its root. Nodes that no
+ *       other version uses are deleted, and so is any NodeData that is in no
+ *       other version.
+ *---------------------------------------------------------------------------*/
+PersistentBinTree::~PersistentBinTree() {
+    release(root);
+}
+
+
+
+/*--------------------------------Assignment Operator--------------------------
+ * Pre: Takes in a read-only reference to another PersistentBinTree,
+ *      otherTree.
+ *
+ * Post: Takes a reference to otherTree's root before giving back this
+ *       version's, so assigning a version to itself is safe. Returns this
+ *       PersistentBinTree.
+ *---------------------------------------------------------------------------*/
+PersistentBinTree& PersistentBinTree::operator=(
+        const PersistentBinTree& otherTree) {
+    const Node* oldRoot = root;
+    root = retain(otherTree.root);
+    release(oldRoot);
+    return *this;
+}
+
+
+
+/*----------------------------------snapshot-----------------------------------
+ * Pre: None.
+ *
+ * Post: Returns a PersistentBinTree that shares this version's root.
+ *---------------------------------------------------------------------------*/
+PersistentBinTree PersistentBinTree::snapshot() const {
+    return PersistentBinTree(*this);
+}
+
+
+
+/*---------------------------------isEmpty-------------------------------------
+ * Pre: None.
+ *
+ * Post: Returns true if this version is empty. Returns false if it is not.
+ *---------------------------------------------------------------------------*/
+bool PersistentBinTree::isEmpty() const {
+    return root == NULL;
+}
+
+
+
+/*-----------------------------------size--------------------------------------
+ * Pre: None.
+ *
+ * Post: Returns the number of NodeData in this version, cached in the root.
+ *---------------------------------------------------------------------------*/
+int PersistentBinTree::size() const {
+    return nodeSize(root);
+}
+
+
+
+/* -------------------------------makeEmpty------------------------------------
+ * Pre: None.
+ *
+ * Post: Gives back this version's reference to its root and makes it empty.
+ *---------------------------------------------------------------------------*/
+void PersistentBinTree::makeEmpty() {
+    release(root);
+    root = NULL;
+}
+
+
+
+/*----------------------------------insert-------------------------------------
+ * Pre: Takes in a pointer to a NodeData, insertPtr, which is the value that
+ *      will be inserted into the tree.
+ *
+ * Post: Returns false if insertPtr's value is already in this version; the
+ *       caller still owns insertPtr. Otherwise builds the new version with
+ *       insertHelper(), makes its root this version's root, gives back the
+ *       old root and returns true. Nodes of the old version that another
+ *       version still uses are left as they are.
+ *---------------------------------------------------------------------------*/
+bool PersistentBinTree::insert(NodeData* insertPtr) {
+    if (findNode(*insertPtr) != NULL) {
+        return false;
+    }
+    const Node* oldRoot = root;
+    root = insertHelper(root, insertPtr);
+    release(oldRoot);
+    return true;
+}
+
+
+
+/*-----------------------------Private: insertHelper---------------------------
+ * Pre: Takes in a pointer to a Node, currentPtr, or NULL. Takes in a pointer
+ *      to a NodeData, insertPtr, whose value is not under currentPtr.
+ *
+ * Post: Returns a reference to a new subtree holding everything under
+ *       currentPtr plus insertPtr, which gets the only new Item. Every Node
+ *       on the path down is rebuilt, sharing its Item, over the new subtree
+ *       on one side and the shared old subtree on the other, and rebalanced
+ *       with balance(). Nothing under currentPtr is changed. Recurses once
+ *       per level, which is O(log n) since the tree is AVL balanced.
+ *---------------------------------------------------------------------------*/
+const PersistentBinTree::Node* PersistentBinTree::insertHelper(
+        const Node* currentPtr, NodeData* insertPtr) {
+    if (currentPtr == NULL) {
+        Item* itemPtr = new Item;
+        itemPtr->data = insertPtr;
+        itemPtr->refs.store(1, memory_order_relaxed);
+        return makeNode(itemPtr, NULL, NULL);
+    }
+    const Item* itemPtr = retain(currentPtr->item);
+    if (*insertPtr < *currentPtr->item->data) {
+        return balance(itemPtr, insertHelper(currentPtr->left, insertPtr)
+                , retain(currentPtr->right));
+    }
+    return balance(itemPtr, retain(currentPtr->left)
+            , insertHelper(currentPtr->right, insertPtr));
+}
+
+
+
+/*-------------------------------Private: balance------------------------------
+ * Pre: Takes in a reference to an Item, item, that the new Node will hold.
+ *      Takes in references to two AVL balanced subtrees, left and right,
+ *      whose heights differ by at most two.
+ *
+ * Post: If the heights differ by less than two, returns makeNode(item, left,
+ *       right). Otherwise does the single or double rotation that balances
+ *       them. The Nodes that move are rebuilt over the same Items, and the
+ *       reference to the old taller child is given back. Returns a
+ *       reference to the balanced subtree.
+ *---------------------------------------------------------------------------*/
+const PersistentBinTree::Node* PersistentBinTree::balance(const Item* item
+        , const Node* left, const Node* right) {
+    int leftHeight = nodeHeight(left);
+    int rightHeight = nodeHeight(right);
+    const Node* newPtr;
+    if (leftHeight > rightHeight + 1) {
+        if (nodeHeight(left->left) >= nodeHeight(left->right)) {
+            newPtr = makeNode(retain(left->item), retain(left->left)
+                    , makeNode(item, retain(left->right), right));
+        } else {
+            const Node* pivotPtr = left->right;
+            newPtr = makeNode(retain(pivotPtr->item)
+                    , makeNode(retain(left->item), retain(left->left)
+                            , retain(pivotPtr->left))
+                    , makeNode(item, retain(pivotPtr->right), right));
+        }
+        release(left);
+    } else if (rightHeight > leftHeight + 1) {
+        if (nodeHeight(right->right) >= nodeHeight(right->left)) {
+            newPtr = makeNode(retain(right->item)
+                    , makeNode(item, left, retain(right->left))
+                    , retain(right->right));
+        } else {
+            const Node* pivotPtr = right->left;
+            newPtr = makeNode(retain(pivotPtr->item)
+                    , makeNode(item, left, retain(pivotPtr->left))
+                    , makeNode(retain(right->item)
+                            , retain(pivotPtr->right), retain(right->right)));
+        }
+        release(right);
+    } else {
+        newPtr = makeNode(item, left, right);
+    }
+    return newPtr;
+}
+
+
+
+/*-------------------------------Private: makeNode-----------------------------
+ * Pre: Takes in a reference to an Item, item, that the new Node will hold.
+ *      Takes in references to two subtrees, left and right, either of which
+ *      may be NULL.
+ *
+ * Post: Returns a new Node over left and right with its height and size
+ *       worked out and one reference, which belongs to the caller.
+ *---------------------------------------------------------------------------*/
+const PersistentBinTree::Node* PersistentBinTree::makeNode(const Item* item
+        , const Node* left, const Node* right) {
+    Node* nodePtr = new Node;
+    nodePtr->item = item;
+    nodePtr->left = left;
+    nodePtr->right = right;
+    int leftHeight = nodeHeight(left);
+    int rightHeight = nodeHeight(right);
+    nodePtr->height = (leftHeight > rightHeight ? leftHeight : rightHeight) + 1;
+    nodePtr->size = nodeSize(left) + nodeSize(right) + 1;
+    nodePtr->refs.store(1, memory_order_relaxed);
+    return nodePtr;
+}
+
+
+
+/*--------------------------------Private: retain------------------------------
+ * Pre: Takes in a read-only pointer to a Node, currentPtr, or NULL.
+ *
+ * Post: Adds one reference to currentPtr and returns it.
+ *---------------------------------------------------------------------------*/
+const PersistentBinTree::Node* PersistentBinTree::retain(
+        const Node* currentPtr) {
+    if (currentPtr != NULL) {
+        currentPtr->refs.fetch_add(1, memory_order_relaxed);
+    }
+    return currentPtr;
+}
+
+
+
+/*-------------------------------Private: release------------------------------
+ * Pre: Takes in a read-only pointer to a Node, currentPtr, or NULL, that the
+ *      caller holds a reference to.
+ *
+ * Post: Gives the reference back. If it was the last one, deletes the Node
+ *       and gives back the Node's references to its Item and its children
+ *       in turn, using an explicit stack, which is only allocated once a
+ *       Node is actually deleted. The release ordering of
+ *       the count, with an acquire by the thread that drops it to zero,
+ *       makes every use of a Node by other versions happen before it is
+ *       deleted.
+ *---------------------------------------------------------------------------*/
+void PersistentBinTree::release(const Node* currentPtr) {
+    if (currentPtr == NULL
+            || currentPtr->refs.fetch_sub(1, memory_order_acq_rel) != 1) {
+        return;
+    }
+    vector<const Node*> stack;
+    stack.push_back(currentPtr->left);
+    stack.push_back(currentPtr->right);
+    release(currentPtr->item);
+    delete currentPtr;
+    while (!stack.empty()) {
+        currentPtr = stack.back();
+        stack.pop_back();
+        if (currentPtr != NULL
+                && currentPtr->refs.fetch_sub(1, memory_order_acq_rel) == 1) {
+            stack.push_back(currentPtr->left);
+            stack.push_back(currentPtr->right);
+            release(currentPtr->item);
+            delete currentPtr;
+        }
+    }
+}
+
+
+
+/*--------------------------------Private: retain------------------------------
+ * Pre: Takes in a read-only pointer to an Item, itemPtr, or NULL.
+ *
+ * Post: Adds one reference to itemPtr and returns it.
+ *---------------------------------------------------------------------------*/
+const PersistentBinTree::Item* PersistentBinTree::retain(
+        const Item* itemPtr) {
+    if (itemPtr != NULL) {
+        itemPtr->refs.fetch_add(1, memory_order_relaxed);
+    }
+    return itemPtr;
+}
+
+
+
+/*-------------------------------Private: release------------------------------
+ * Pre: Takes in a read-only pointer to an Item, itemPtr, or NULL, that the
+ *      caller holds a reference to.
+ *
+ * Post: Gives the reference back. If it was the last one, deletes the Item
+ *       and its NodeData, with the same ordering as releasing a Node.
+ *---------------------------------------------------------------------------*/
+void PersistentBinTree::release(const Item* itemPtr) {
+    if (itemPtr != NULL
+            && itemPtr->refs.fetch_sub(1, memory_order_acq_rel) == 1) {
+        delete itemPtr->data;
+        delete itemPtr;
+    }
+}
+
+
+
+/*-----------------------------Private: nodeHeight-----------------------------
+ * Pre: Takes in a read-only pointer to a Node, currentPtr, or NULL.
+ *
+ * Post: Returns the cached height of the subtree at currentPtr. An empty
+ *       subtree has a height of 0.
+ *---------------------------------------------------------------------------*/
+int PersistentBinTree::nodeHeight(const Node* currentPtr) {
+    if (currentPtr == NULL) {
+        return 0;
+    }
+    return currentPtr->height;
+}
+
+
+
+/*------------------------------Private: nodeSize------------------------------
+ * Pre: Takes in a read-only pointer to a Node, currentPtr, or NULL.
+ *
+ * Post: Returns the cached number of Nodes in the subtree at currentPtr. An
+ *       empty subtree has a size of 0.
+ *---------------------------------------------------------------------------*/
+int PersistentBinTree::nodeSize(const Node* currentPtr) {
+    if (currentPtr == NULL) {
+        return 0;
+    }
+    return currentPtr->size;
+}
+
+
+
+/*------------------------------Private: findNode------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target.
+ *
+ * Post: Descends from the root with one < comparison per level, remembering
+ *       the last Node that was not less than target, and checks only that
+ *       one for equality at the bottom. Returns the Node holding target, or
+ *       NULL if it is not in this version.
+ *---------------------------------------------------------------------------*/
+const PersistentBinTree::Node* PersistentBinTree::findNode(
+        const NodeData& target) const {
+    const Node* currentPtr = root;
+    const Node* candidatePtr = NULL;
+    while (currentPtr != NULL) {
+        if (*currentPtr->item->data < target) {
+            currentPtr = currentPtr->right;
+        } else {
+            candidatePtr = currentPtr;
+            currentPtr = currentPtr->left;
+        }
+    }
+    if (candidatePtr != NULL && !(target < *candidatePtr->item->data)) {
+        return candidatePtr;
+    }
+    return NULL;
+}
+
+
+
+/*-------------------------------retrieve-------------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target, which is the
+ *      value to look for. Takes in a pointer reference to a read-only
+ *      NodeData, nodeDataPtr.
+ *
+ * Post: Makes nodeDataPtr point to the NodeData equal to target and returns
+ *       true. If target is not in this version, sets nodeDataPtr to NULL
+ *       and returns false.
+ *---------------------------------------------------------------------------*/
+bool PersistentBinTree::retrieve(const NodeData& target
+        , const NodeData*& nodeDataPtr) const {
+    const Node* nodePtr = findNode(target);
+    if (nodePtr != NULL) {
+        nodeDataPtr = nodePtr->item->data;
+        return true;
+    }
+    nodeDataPtr = NULL;
+    return false;
+}
+
+
+
+/*--------------------------------getHeight------------------------------------
+ * Pre: Takes in a read-only reference to a NodeData, target.
+ *
+ * Post: Returns the cached height of the Node holding target, counted from
+ *       the bottom of the tree, or 0 if target is not in this version.
+ *---------------------------------------------------------------------------*/
+int PersistentBinTree::getHeight(const NodeData& target) const {
+    const Node* nodePtr = findNode(target);
+    if (nodePtr != NULL) {
+        return nodePtr->height;
+    }
+    return 0;
+}
+
+
+
+/* -----------------------------Output Operator--------------------------------
+ * Pre: Takes in a reference to an ostream, outStream, and a read-only
+ *      reference to a PersistentBinTree, otherTree.
+ *
+ * Post: Prints every NodeData in otherTree's version in order, using an
+ *       explicit stack, followed by an end line. Returns outStream.
+ *---------------------------------------------------------------------------*/
+ostream& operator<<(ostream& outStream, const PersistentBinTree& otherTree) {
+    typedef PersistentBinTree::Node Node;
+    vector<const Node*> stack;
+    const Node* currentPtr = otherTree.root;
+    while (currentPtr != NULL || !stack.empty()) {
+        while (currentPtr != NULL) {
+            stack.push_back(currentPtr);
+            currentPtr = currentPtr->left;
+        }
+        currentPtr = stack.back();
+        stack.pop_back();
+        outStream << *currentPtr->item->data << " ";
+        currentPtr = currentPtr->right;
+    }
+    outStream << endl;
+    return outStream;
+}
@@ -0,0 +1,167 @@
+#ifndef PERSISTENTBINTREE_H
+#define PERSISTENTBINTREE_H
+
+#include "nodedata.h"
+#include <atomic>
+
+/* This class, PersistentBinTree, is an AVL balanced Binary Search Tree whose
+ * Nodes never change once they are built, so any number of versions of it
+ * can share them.
+ *
+ * insert() does not touch the Nodes already in the tree. It builds new
+ * copies of the O(log n) Nodes on the path to the new leaf, which point at
+ * the same subtrees as the old ones off the path, and makes the new copy of
+ * the root this tree's root. Any other version still holding the old root
+ * sees exactly what it saw before.
+ *
+ * snapshot(), the copy constructor and assignment share the root in O(1).
+ * Every Node counts the versions and parent Nodes that point at it, and is
+ * deleted by whichever version lets go of it last.
+ * The counts are atomic, so different versions may be read, changed and
+ * destroyed by different threads at the same time even while they share
+ * Nodes. One PersistentBinTree object must still not be changed while
+ * another thread is using that same object.
+ *
+ * A NodeData is kept in an Item, which counts the Nodes holding it, and a
+ * path copy shares the Item with the Node it replaces instead of copying the
+ * NodeData. So an insert allocates O(log n) Nodes but only one Item, and a
+ * NodeData stays where it is until every Node holding it is gone, just as
+ * it would in a BinTree. Nodes and Items come from the heap instead of a
+ * NodePool because the last version to let go of one may be on any thread.
+ * */
+class PersistentBinTree {
+
+friend ostream& operator<<(ostream& outStream
+        , const PersistentBinTree& otherTree);
+
+
+private:
+    struct Item {
+        NodeData* data;                     // owned, never changes
+        mutable atomic<int> refs;           // Nodes holding it
+    };
+    struct Node {
+        const Item* item;                   // shared with other copies
+        const Node* left;                   // left subtree, shared
+        const Node* right;                  // right subtree, shared
+        int height;                         // height of this subtree
+        int size;                           // Nodes in this subtree
+        mutable atomic<int> refs;           // versions and parents using it
+    };
+    const Node* root;                       // root of this version
+
+
+    //---------------------------makeNode--------------------------------------
+    // Builds a Node holding item over left and right. The new Node takes
+    // over the caller's references to item, left and right, and the caller
+    // gets the only reference to the new Node.
+    static const Node* makeNode(const Item* item, const Node* left
+            , const Node* right);
+
+
+    //---------------------------retain / release------------------------------
+    // Adds a reference to currentPtr and returns it, or gives one back,
+    // deleting every Node that no one is using any more, and every Item no
+    // Node holds any more. All of them accept NULL.
+    static const Node* retain(const Node* currentPtr);
+    static void release(const Node* currentPtr);
+    static const Item* retain(const Item* itemPtr);
+    static void release(const Item* itemPtr);
+
+
+    //---------------------------nodeHeight / nodeSize-------------------------
+    // Return the cached height or size of a subtree. 0 if NULL.
+    static int nodeHeight(const Node* currentPtr);
+    static int nodeSize(const Node* currentPtr);
+
+
+    //---------------------------balance---------------------------------------
+    // Same as makeNode(), but first does the single or double rotation that
+    // keeps the result AVL balanced, building new Nodes for the ones that
+    // move instead of changing them.
+    static const Node* balance(const Item* item, const Node* left
+            , const Node* right);
+
+
+    //---------------------------insertHelper----------------------------------
+    // Returns a new version of the subtree at currentPtr with insertPtr added,
+    // sharing every subtree off the path. insertPtr must not already be in it.
+    static const Node* insertHelper(const Node* currentPtr
+            , NodeData* insertPtr);
+
+
+    //---------------------------findNode--------------------------------------
+    // Returns the Node holding target, or NULL if it is not in this version.
+    const Node* findNode(const NodeData& target) const;
+
+
+public:
+
+    //---------------------------Empty Constructor-----------------------------
+    // Creates an empty PersistentBinTree.
+    PersistentBinTree();
+
+
+    // -------------------------Copy Constructor------------------------------
+    // Creates another version that shares every Node with the other one, in
+    // O(1).
+    PersistentBinTree(const PersistentBinTree&);
+
+
+    // ---------------------------Destructor----------------------------------
+    // Lets go of this version's Nodes. Only the ones no other version uses
+    // are deleted.
+    ~PersistentBinTree();
+
+
+    // -----------------------Assignment Operator--------------------------
+    // Makes this the same version as the other one in O(1). Returns this
+    // PersistentBinTree.
+    PersistentBinTree& operator=(const PersistentBinTree&);
+
+
+    // ---------------------------snapshot--------------------------------------
+    // Returns the current version in O(1). Later changes to this
+    // PersistentBinTree are not seen by it, and changes to it are not seen
+    // here.
+    PersistentBinTree snapshot() const;
+
+
+    // ---------------------------isEmpty---------------------------------------
+    // Returns true if empty. Returns false if not.
+    bool isEmpty() const;
+
+
+    // ---------------------------size------------------------------------------
+    // Returns the number of NodeData in this version in O(1).
+    int size() const;
+
+
+    //---------------------------makeEmpty-------------------------------------
+    // Makes this version empty. Other versions are unchanged.
+    void makeEmpty();
+
+
+    //------------------------------insert-------------------------------------
+    // Inserts the NodeData, which the tree then owns, by copying the path to
+    // it. Returns false, and does not take ownership, if its value is already
+    // in the tree. Other versions are unchanged.
+    bool insert(NodeData* s);
+
+
+    // -------------------------retrieve--------------------------------------
+    // Returns true if NodeData is in this version and points the second
+    // argument at it. Returns false and sets it to NULL otherwise. The
+    // NodeData must not be changed, since other versions may share it. The
+    // pointer stays valid through later inserts, until every version holding
+    // that NodeData has been emptied, reassigned or destroyed.
+    bool retrieve(const NodeData &, const NodeData *&) const;
+
+
+    // --------------------------getHeight-----------------------------------
+    // Returns the height of the Node holding NodeData from the bottom of the
+    // tree, or 0 if it is not there.
+    int getHeight(const NodeData &) const;
+};
+
+#endif